@@ -24,9 +24,11 @@
 #include <sstream>
 #include <iomanip>
 #include <list>
+#include <deque>
 #include <random>
 #include <thread>
 #include <future>
+#include <atomic>
 #if defined(__linux__)
 #include <sys/wait.h>
 #include <unistd.h>
@@ -35,6 +37,8 @@
 #include "moporgic/util.h"
 #include "moporgic/math.h"
 #include "moporgic/shm.h"
+#include "moporgic/page.h"
+#include "moporgic/numa.h"
 #include "board.h"
 
 namespace moporgic {
@@ -91,7 +95,7 @@ typedef float numeric;
 
 class weight {
 public:
-	inline weight() : name(), length(0), raw(nullptr) {}
+	inline weight() : name(), length(0), raw(nullptr), scale(1) {}
 	inline weight(const weight& w) = default;
 	inline ~weight() {}
 
@@ -109,50 +113,177 @@ public:
 		inline constexpr numeric& operator +=(numeric delta) { return value += delta; }
 		declare_comparators_with(const numeric&, value, v, inline constexpr);
 	};
-	struct coherence : structure {
-		numeric accum, updvu;
+	struct coherence : structure { // entries are stored in blocks of lanes values, lanes accums, and lanes updvus
 		static constexpr u32 code = to_hash("coherence");
 		static constexpr numeric cinit = std::numeric_limits<numeric>::min();
-		inline constexpr coherence() : structure(), accum(cinit), updvu(cinit) {}
-		inline constexpr coherence(const coherence& c) = default;
-		inline constexpr coherence& operator =(const coherence& c) = default;
+#if defined(PREFER_COHERENCE_SOA)
+		static constexpr size_t lanes = 16; // blocked SoA, estimators only touch the value lanes
+#else
+		static constexpr size_t lanes = 1; // AoS, an update hits the same cache line as its estimate
+#endif
+		inline constexpr coherence() : structure() {} // accum and updvu are initialized by weight::alloc
+		inline constexpr coherence(const coherence& c) = delete; // an entry is only meaningful in its table
+		inline constexpr coherence& operator =(const coherence& c) = delete;
 		inline constexpr numeric& operator =(numeric v) {
-			accum = updvu = cinit;
+			accum() = updvu() = cinit;
 			return value = v;
 		}
 		inline constexpr numeric& operator +=(numeric delta) {
-			value += delta * (std::abs(accum) / updvu);
-			accum += delta;
-			updvu += std::abs(delta);
+			value += delta * (std::abs(accum()) / updvu());
+			accum() += delta;
+			updvu() += std::abs(delta);
 			return value;
 		}
+		inline constexpr numeric& unit(u32 u) { return (&value)[u * lanes]; } // 0 for value, 1 for accum, 2 for updvu
+		inline constexpr numeric& accum() { return unit(1); }
+		inline constexpr numeric& updvu() { return unit(2); }
 
-		template<size_t i> struct unit : std::array<numeric, 3> {
-			constexpr inline operator numeric&() { return operator [](i); }
-			constexpr inline operator const numeric&() const { return operator [](i); }
-			constexpr inline numeric& operator =(numeric v) { return (operator [](i) = v); }
-			declare_comparators_with(const numeric&, operator [](i), v, constexpr inline);
+		static constexpr inline size_t slot(size_t i) { return i + ((i & ~(lanes - 1)) << 1); }
+		static constexpr inline size_t slots(size_t n) { return ((n + lanes - 1) & ~(lanes - 1)) * 3; }
+		struct view { // access the value lane as an array
+			coherence* raw;
+			constexpr inline numeric& operator [](size_t i) const { return raw[slot(i)].value; }
 		};
 	};
+	template<u32 form> struct halfword { // 16-bit storage, accumulated in numeric and rounded stochastically on update
+		u16 bits;
+		static constexpr u32 code = form;
+		inline constexpr halfword() : bits(0) {}
+		inline constexpr halfword(const halfword& h) = default;
+		inline constexpr halfword& operator =(const halfword& h) = default;
+		inline operator numeric() const { return decode(bits); }
+		inline numeric operator =(numeric v) { return decode(bits = encode(v)); }
+		inline numeric operator +=(numeric delta) { return decode(bits = dither(decode(bits) + delta)); }
+
+		static inline numeric decode(u16 h) {
+			if constexpr (form == to_hash("bfloat16")) {
+				u32 x = u32(h) << 16;
+				return raw_cast<f32>(x);
+			}
+#if defined(__F16C__)
+			return _cvtsh_ss(h);
+#else
+			return f32(f16::as(h));
+#endif
+		}
+		static inline u16 encode(numeric v) { // round to nearest even
+			f32 f = v;
+			if constexpr (form == to_hash("bfloat16")) {
+				u32 x = raw_cast<u32>(f);
+				return (x + 0x7fff + ((x >> 16) & 1)) >> 16;
+			}
+#if defined(__F16C__)
+			return _cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT);
+#else
+			u16 h = 0;
+			f16::as(h) = f16(f);
+			return h;
+#endif
+		}
+		static inline u16 dither(numeric v) { // round up or down with the probability of the distances
+			u32 r = noise();
+			if constexpr (form == to_hash("bfloat16")) {
+				f32 f = v;
+				return (raw_cast<u32>(f) + (r & 0xffff)) >> 16; // bf16 is a truncated f32
+			}
+#if defined(__F16C__)
+			f32 f = v; // add random bits below the f16 ulp (13 bits, more for subnormals), then truncate
+			u32 x = raw_cast<u32>(f), e = (x >> 23) & 0xff;
+			if (e == 0xff) return encode(v);
+			u32 low = 13 + std::min<u32>(113 - std::min<u32>(e, 113), 10);
+			x += r & ((1u << low) - 1);
+			return _cvtss_sh(raw_cast<f32>(x), _MM_FROUND_TO_ZERO);
+#else
+			u16 h = encode(v), n;
+			numeric e = v - decode(h);
+			if (e == 0) return h;
+			if ((h & 0x7fff) == 0) n = e > 0 ? 0x0001 : 0x8001;
+			else n = (e > 0) == !(h & 0x8000) ? h + 1 : h - 1; // next representable value toward v
+			return (r >> 8) * 0x1p-24f < e / (decode(n) - decode(h)) ? n : h;
+#endif
+		}
+		static inline u32 noise() { thread_local moporgic::xoshiro256ss gen; return gen(); } // never touches the game RNG
+	};
+	typedef halfword<to_hash("float16")> float16;
+	typedef halfword<to_hash("bfloat16")> bfloat16;
+	struct quantized { // 16-bit fixed-point storage for evaluation, all tables share the same unit when in use
+		i16 value;
+		static constexpr u32 code = to_hash("quantized");
+		inline constexpr quantized() : value(0) {}
+		inline operator numeric() const { return value * unit(); }
+		inline numeric operator +=(numeric delta) { return *this; } // never updated
+		static inline numeric& unit() { static numeric u = 1; return u; }
+	};
 	typedef structure segment;
 	static u32& type() { static u32 code = segment::code; return code; }
 	static u32& type(u32 code) { return type() = code; }
+	static bool& paged() { static bool use = false; return use; } // write page-aligned tables (serial 6)
+	static std::string& mapping() { static std::string path; return path; } // map page-aligned tables from this file
+	static bool& sparse() { static bool use = false; return use; } // reserve tables lazily, write non-default chunks only (serial 7)
+	template<int rw = 0, typename type> static inline_always void prefetch(const type* p) { // also prefetch the accum and updvu for writing
+		__builtin_prefetch(p, rw);
+		if constexpr (rw && std::is_same<type, coherence>::value && coherence::lanes > 1) {
+			__builtin_prefetch(&p->value + coherence::lanes, 1);
+			__builtin_prefetch(&p->value + (coherence::lanes << 1), 1);
+		}
+	}
+	template<typename type> static constexpr inline size_t slot(size_t i) { // position of the i-th entry in a table
+		if constexpr (std::is_same<type, coherence>::value) return coherence::slot(i);
+		return i;
+	}
 
 	inline sign_t sign() const { return name; }
 	inline size_t size() const { return length; }
 	constexpr inline segment& operator [](size_t i) { return pointer_cast<segment>(raw)[i]; }
-	template<typename type = segment> constexpr inline type& at(size_t i) { return pointer_cast<type>(raw)[i]; }
-	template<typename type = segment> constexpr inline type* data(size_t i = 0) const { return pointer_cast<type>(raw) + i; }
+	template<typename type = segment> constexpr inline type& at(size_t i) const { return pointer_cast<type>(raw)[slot<type>(i)]; }
+	template<typename type = segment> constexpr inline type* data(size_t i = 0) const { return pointer_cast<type>(raw) + slot<type>(i); }
 	template<typename type = segment> constexpr inline clip<type> value() const { return { data<type>(0), data<type>(length) }; }
 	inline operator bool() const { return raw; }
+	inline size_t bytes() const {
+		switch (weight::type()) {
+		default:
+		case structure::code: return length * sizeof(structure);
+		case coherence::code: return coherence::slots(length) * sizeof(coherence);
+		case float16::code: return length * sizeof(float16);
+		case bfloat16::code: return length * sizeof(bfloat16);
+		case quantized::code: return length * sizeof(quantized);
+		}
+	}
+	inline size_t touched() const { // bytes of pages holding non-zero values, or of resident pages for SHM since reads also commit them
+		return shm::enable<segment>() ? page::resident(raw, bytes()) : page::written(raw, bytes());
+	}
+	inline weight rebind(void* data) const { weight w(*this); w.raw = cast<structure*>(data); return w; } // e.g., a replica
+	inline numeric& unit() { return scale; }
+	inline numeric unit() const { return scale; }
 	declare_comparators(const weight&, sign(), inline);
 
+	template<typename source> void quantize(source value) { // map the max magnitude to 32767, value(i) gives the real value
+		numeric peak = 0;
+		for (size_t i = 0; i < length; i++) peak = std::max(peak, std::abs(numeric(value(i))));
+		numeric step = peak ? peak / 32767 : 0;
+		for (size_t i = 0; i < length; i++) at<quantized>(i).value = step ? std::lround(value(i) / step) : 0;
+		scale = step; // value(i) may read this table with the previous scale
+	}
+	static void unify() { // rescale all tables to the largest scale, so that estimators can read them directly
+		numeric unit = 0;
+		for (weight w : wghts()) unit = std::max(unit, w.unit());
+		quantized::unit() = unit = unit ? unit : 1;
+		for (weight& w : wghts()) {
+			if (w.unit() != unit)
+				for (quantized& q : w.value<quantized>()) q.value = std::lround(q.value * w.unit() / unit);
+			w.unit() = unit;
+		}
+	}
+
 	friend std::ostream& operator <<(std::ostream& out, const weight& w) {
-		u32 code = 4;
+		u32 code = paged() ? 6 : sparse() ? 7 : weight::type() != quantized::code ? 4 : 5;
 		write_cast<u8>(out, code);
 		switch (code) {
 		default:
-		case 4: [&]() {
+		case 4:
+		case 5:
+		case 6:
+		case 7: [&]() {
 			try { // write sign as 32-bit integer if possible
 				size_t idx = 0;
 				u32 sign = std::stoul(w.sign(), &idx, 16);
@@ -163,24 +294,68 @@ public:
 			} catch (std::logic_error&) { // otherwise, write it as string
 				out.write(w.sign().append(8, ' ').c_str(), 8);
 			}
+			if (code == 5) write_cast<f32>(out, w.unit()); // serial 5 is quantized with a per-table scale
+			if (code >= 6) write_cast<f32>(out, weight::type() == quantized::code ? w.unit() : 0); // serial 6 is page-aligned, 7 is chunked
 			auto write_unit = [](std::ostream& out, auto data) {
 				write_cast<numeric>(out, data.begin(), data.end());
 			};
+			auto write_head = [&](u16 blkz, u64 size) { // block size, length, and padding (serial 6)
+				write_cast<u16>(out, blkz);
+				write_cast<u64>(out, size);
+				if (code != 6) return;
+				std::streamoff pos = out.tellp();
+				u32 pad = pos != -1 ? (-(pos + 4)) & (page::align - 1) : 0;
+				write_cast<u32>(out, pad);
+				while (pad--) out.put(0);
+			};
+			auto write_table = [&](size_t size, auto value, numeric init, auto write) { // write entries [0, size), or only chunks with non-default values (serial 7)
+				if (code != 7) return write(0, size);
+				u32 chunk = 1 << 12;
+				size_t num = (size + chunk - 1) / chunk;
+				std::vector<char> bits((num + 7) >> 3);
+				// a lazily reserved table is all default in its non-resident pages, so check residency before touching them
+				bool lazy = weight::sparse() && weight::type() != coherence::code && weight::type() != quantized::code;
+				size_t blkz = w.bytes() / (w.size() ?: 1);
+				for (size_t c = 0; c < num; c++) {
+					if (lazy && !page::resident(cast<char*>(w.data()) + c * chunk * blkz, (std::min(size, (c + 1) * chunk) - c * chunk) * blkz)) continue;
+					for (size_t i = c * chunk; i < std::min(size, (c + 1) * chunk); i++)
+						if (value(i) != init) { bits[c >> 3] |= 1 << (c & 7); break; }
+				}
+				write_cast<u32>(out, chunk);
+				out.write(bits.data(), bits.size());
+				for (size_t c = 0; c < num; c++)
+					if (bits[c >> 3] & (1 << (c & 7))) write(c * chunk, std::min(size, (c + 1) * chunk));
+			};
 			switch (weight::type()) { // write value table
 			default:
 			case structure::code:
-				write_cast<u16>(out, sizeof(numeric));
-				write_cast<u64>(out, w.size());
-				write_unit(out, w.value<structure>());
+				write_head(sizeof(numeric), w.size());
+				write_table(w.size(), [&](size_t i) { return numeric(w.at<structure>(i)); }, 0,
+					[&](size_t i, size_t n) { write_unit(out, clip<structure>{ w.data<structure>(i), w.data<structure>(n) }); });
 				break;
-			case coherence::code: // also write coherence tables if enabled
-				write_cast<u16>(out, sizeof(numeric));
-				write_cast<u64>(out, w.size());
-				write_unit(out, w.value<coherence::unit<0>>());
+			case float16::code: // f16 is stored as is
+				write_head(sizeof(f16), w.size());
+				write_table(w.size(), [&](size_t i) { return numeric(w.at<float16>(i)); }, 0,
+					[&](size_t i, size_t n) { write_cast<f16>(out, w.data<float16>(i), w.data<float16>(n)); });
+				break;
+			case bfloat16::code: // bf16 is stored as numeric for compatibility
+				write_head(sizeof(numeric), w.size());
+				write_table(w.size(), [&](size_t i) { return numeric(w.at<bfloat16>(i)); }, 0,
+					[&](size_t i, size_t n) { write_unit(out, clip<bfloat16>{ w.data<bfloat16>(i), w.data<bfloat16>(n) }); });
+				break;
+			case quantized::code:
+				write_head(sizeof(i16), w.size());
+				write_table(w.size(), [&](size_t i) { return numeric(w.at<quantized>(i).value); }, 0,
+					[&](size_t i, size_t n) { write_cast<i16>(out, w.data<i16>(i), w.data<i16>(n)); });
+				break;
+			case coherence::code: // also write coherence tables if enabled, accum and updvu are stored as one table
+				write_head(sizeof(numeric), w.size());
+				write_table(w.size(), [&](size_t i) { return w.at<coherence>(i).unit(0); }, 0,
+					[&](size_t i, size_t n) { while (i < n) write_cast<numeric>(out, w.at<coherence>(i++).unit(0)); });
 				write_cast<u16>(out, sizeof(numeric));
 				write_cast<u64>(out, w.size() + w.size());
-				write_unit(out, w.value<coherence::unit<1>>());
-				write_unit(out, w.value<coherence::unit<2>>());
+				write_table(w.size() + w.size(), [&](size_t i) { return w.at<coherence>(i % w.size()).unit(1 + i / w.size()); }, coherence::cinit,
+					[&](size_t i, size_t n) { while (i < n) write_cast<numeric>(out, w.at<coherence>(i % w.size()).unit(1 + i / w.size())), i++; });
 				break;
 			}
 			// reserved for additional fields
@@ -194,36 +369,86 @@ public:
 		read_cast<u8>(in, code);
 		switch (code) {
 		default:
-		case 4: [&]() {
-			// read name (raw), block size, length, and value table
+		case 4:
+		case 5:
+		case 6:
+		case 7: [&]() {
+			// read name (raw), scale (serial 5, 6, and 7), block size, length, and value table
 			in.read(const_cast<char*>(w.name.assign(8, ' ').data()), 8);
-			auto read_unit = [blkz = read<u16>(in)](std::istream& in, auto data) {
+			f32 unit = code >= 5 ? read<f32>(in) : 0;
+			u16 blkz = read<u16>(in);
+			auto read_unit = [blkz, unit](std::istream& in, auto data) {
+				if (unit) { // dequantize 16-bit fixed-point values
+					for (auto& v : data) v = read<i16>(in) * unit;
+					return;
+				}
 				switch (blkz) { // binaries may typedef different numeric
 				case 2: read_cast<f16>(in, data.begin(), data.end()); break;
 				case 4: read_cast<f32>(in, data.begin(), data.end()); break;
 				case 8: read_cast<f64>(in, data.begin(), data.end()); break;
 				}
 			};
-			w.raw = weight::alloc(w.length = read<u64>(in));
-			switch (weight::type()) {
+			auto read_data = [&](auto data) { // zeros are not written so that the pages of sparse tables remain uncommitted
+				if (!weight::sparse()) return read_unit(in, data);
+				std::vector<numeric> buf(std::min(data.size(), size_t(1) << 16));
+				for (size_t i = 0, n; i < data.size(); i += n) {
+					n = std::min(buf.size(), data.size() - i);
+					read_unit(in, clip<numeric>{ buf.data(), buf.data() + n });
+					for (size_t k = 0; k < n; k++) if (buf[k] != 0) data[i + k] = buf[k];
+				}
+			};
+			auto read_table = [&](size_t size, auto func) { // read entries [0, size), or only the stored chunks (serial 7)
+				if (code != 7) return func(0, size);
+				size_t chunk = read<u32>(in), num = (size + chunk - 1) / chunk;
+				std::vector<char> bits((num + 7) >> 3);
+				in.read(bits.data(), bits.size());
+				for (size_t c = 0; c < num; c++)
+					if (bits[c >> 3] & (1 << (c & 7))) func(c * chunk, std::min(size, (c + 1) * chunk));
+			};
+			w.length = read<u64>(in);
+			if (code == 6) in.ignore(read<u32>(in)); // skip the padding before the page-aligned table
+			bool mapped = code == 6 && (w.raw = weight::map(in, blkz, unit, w.length));
+			if (mapped && unit) w.unit() = unit;
+			if (!mapped) w.raw = weight::alloc(w.length);
+			if (!mapped) switch (weight::type()) {
 			default:
 			case structure::code:
-				read_unit(in, w.value<structure>());
+				read_table(w.size(), [&](size_t i, size_t n) { read_data(clip<structure>{ w.data<structure>(i), w.data<structure>(n) }); });
+				break;
+			case float16::code:
+				read_table(w.size(), [&](size_t i, size_t n) { read_data(clip<float16>{ w.data<float16>(i), w.data<float16>(n) }); });
 				break;
-			case coherence::code:
-				read_unit(in, w.value<coherence::unit<0>>());
+			case bfloat16::code:
+				read_table(w.size(), [&](size_t i, size_t n) { read_data(clip<bfloat16>{ w.data<bfloat16>(i), w.data<bfloat16>(n) }); });
+				break;
+			case quantized::code:
+				if (unit) {
+					read_table(w.size(), [&](size_t i, size_t n) { read_cast<i16>(in, w.data<i16>(i), w.data<i16>(n)); });
+					w.unit() = unit;
+				} else { // quantize after the whole table is read
+					std::vector<numeric> buf(w.size());
+					read_table(w.size(), [&](size_t i, size_t n) { read_unit(in, clip<numeric>{ buf.data() + i, buf.data() + n }); });
+					w.quantize([&](size_t i) { return buf[i]; });
+				}
+				break;
+			case coherence::code: [&]() {
+				auto read_lane = [&](size_t i, size_t n) { // units are stored separately, so scatter them into blocks
+					std::vector<numeric> buf(n - i);
+					read_unit(in, clip<numeric>{ buf.data(), buf.data() + buf.size() });
+					for (numeric v : buf) w.at<coherence>(i % w.size()).unit(i / w.size()) = v, i++;
+				};
+				read_table(w.size(), read_lane);
 				// also try loading coherence parameters
-				if (read<u16>(in) == 0 && in.seekg(-2, std::ios::cur)) break;
+				if (read<u16>(in) == 0 && in.seekg(-2, std::ios::cur)) return;
 				in.ignore(8);
-				read_unit(in, w.value<coherence::unit<1>>());
-				read_unit(in, w.value<coherence::unit<2>>());
+				read_table(w.size() + w.size(), [&](size_t i, size_t n) { read_lane(i + w.size(), n + w.size()); });
 				// fix legacy coherence::cinit == 0
-				for (coherence& c : w.value<coherence>())
-					if (c.updvu == 0) c = numeric(c);
-				break;
+				for (size_t i = 0; i < w.size(); i++)
+					if (w.at<coherence>(i).updvu() == 0) w.at<coherence>(i) = w.at<coherence>(i).value;
+			}(); break;
 			}
 			// skip unrecognized fields
-			for (u32 blkz; (blkz = read<u16>(in)); in.ignore(blkz * read<u64>(in)));
+			for (u32 blkz; (blkz = read<u16>(in)); read_table(read<u64>(in), [&](size_t i, size_t n) { in.ignore(blkz * (n - i)); }));
 			// finalize name and display width
 			if (raw_cast<u16>(w.name[6]) == 0) { // name is serialized as integer
 				u32 sign = raw_cast<u32>(w.name[0]);
@@ -307,35 +532,57 @@ public:
 	inline weight(sign_t sign, const container& src = wghts()) : weight(src(sign)) {}
 
 private:
-	inline weight(sign_t sign, size_t size) : name(sign), length(size), raw(alloc(size)) {}
+	inline weight(sign_t sign, size_t size) : name(sign), length(size), raw(alloc(size)), scale(1) {}
 
 	static inline structure* alloc(size_t size) {
 		switch (weight::type()) {
 		default:
-		case structure::code: return shm::enable<segment>() ? shm::alloc<structure>(size) : new structure[size]();
-		case coherence::code: return shm::enable<segment>() ? shm::alloc<coherence>(size) : new coherence[size]();
+		case structure::code: return shm::enable<segment>() ? shm::alloc<structure>(size, sparse()) : page::alloc<structure>(size, sparse());
+		case coherence::code: return init(shm::enable<segment>() ? shm::alloc<coherence>(coherence::slots(size)) : page::alloc<coherence>(coherence::slots(size)), size);
+		case float16::code: return pointer_cast<structure>(shm::enable<segment>() ? shm::alloc<float16>(size, sparse()) : page::alloc<float16>(size, sparse()));
+		case bfloat16::code: return pointer_cast<structure>(shm::enable<segment>() ? shm::alloc<bfloat16>(size, sparse()) : page::alloc<bfloat16>(size, sparse()));
+		case quantized::code: return pointer_cast<structure>(shm::enable<segment>() ? shm::alloc<quantized>(size) : page::alloc<quantized>(size));
 		}
 	}
-	static inline void free(structure* v) { shm::enable<segment>() ? shm::free<structure>(v) : delete[] v; }
+	static inline structure* init(coherence* c, size_t size) {
+		for (size_t i = 0; i < size; i++) c[coherence::slot(i)] = 0;
+		return c;
+	}
+	static inline void free(structure* v) { shm::enable<segment>() ? shm::free<structure>(v) : page::free<structure>(v); }
+	static inline structure* map(std::istream& in, u16 blkz, f32 unit, size_t size) { // map the table as is if possible
+		if (mapping().empty() || shm::enable<segment>()) return nullptr;
+		bool direct = false;
+		switch (weight::type()) {
+		case structure::code: direct = !unit && blkz == sizeof(structure); break;
+		case float16::code:   direct = !unit && blkz == sizeof(float16); break;
+		case quantized::code: direct = unit && blkz == sizeof(quantized); break;
+		}
+		std::streamoff pos = direct ? std::streamoff(in.tellg()) : -1;
+		void* raw = pos != -1 ? page::map(mapping(), pos, size * blkz) : nullptr;
+		if (raw) in.seekg(size * blkz, std::ios::cur);
+		return cast<structure*>(raw);
+	}
 
 	sign_t name;
 	size_t length;
 	structure* raw;
+	numeric scale;
 };
 
 class indexer {
 public:
-	inline indexer() : name(), map(nullptr) {}
+	inline indexer() : name(), map(nullptr), bind(nullptr), args(nullptr) {}
 	inline indexer(const indexer& i) = default;
 	inline ~indexer() {}
 
 	typedef std::string sign_t;
 	typedef u64(*mapper)(const board&);
+	typedef u64(*binder)(const board&, const void*);
 
 	inline sign_t sign() const { return name; }
 	constexpr inline mapper index() const { return map; }
-	constexpr inline u64 operator ()(const board& b) const { return (*map)(b); }
-	inline operator bool() const { return map; }
+	constexpr inline u64 operator ()(const board& b) const { return map ? (*map)(b) : (*bind)(b, args); }
+	inline operator bool() const { return map || bind; }
 	declare_comparators(const indexer&, sign(), inline);
 
 	class container : public list<indexer> {
@@ -344,6 +591,8 @@ public:
 		container(const clip<indexer>& i) : list<indexer>(i) {}
 	public:
 		indexer& make(sign_t sign, mapper map) { return list<indexer>::emplace_back(indexer(sign, map)); }
+		indexer& make(sign_t sign, binder bind, const void* args) { return list<indexer>::emplace_back(indexer(sign, bind, args)); }
+		indexer& make(sign_t sign, const indexer& i) { return list<indexer>::emplace_back(indexer(sign, i)); }
 		indexer erase(sign_t sign) { auto it = find(sign); auto x = *it; list<indexer>::erase(it); return x; }
 		indexer* find(sign_t sign) const { return std::find_if(begin(), end(), [=](const indexer& i) { return i.sign() == sign; }); }
 		indexer& at(sign_t sign) const { auto it = find(sign); if (it != end()) return *it; throw std::out_of_range("indexer::at"); }
@@ -353,14 +602,20 @@ public:
 
 	static inline indexer::container& idxrs() { static container i; return i; }
 	static inline indexer& make(sign_t sign, mapper map, container& src = idxrs()) { return src.make(sign, map); }
+	static inline indexer& make(sign_t sign, binder bind, const void* args, container& src = idxrs()) { return src.make(sign, bind, args); }
+	static inline indexer& make(sign_t sign, const indexer& i, container& src = idxrs()) { return src.make(sign, i); }
 	static inline size_t erase(sign_t sign, container& src = idxrs()) { return src.erase(sign); }
 	inline indexer(sign_t sign, const container& src = idxrs()) : indexer(src(sign)) {}
 
 private:
-	inline indexer(sign_t sign, mapper map) : name(sign), map(map) {}
+	inline indexer(sign_t sign, mapper map) : name(sign), map(map), bind(nullptr), args(nullptr) {}
+	inline indexer(sign_t sign, binder bind, const void* args) : name(sign), map(nullptr), bind(bind), args(args) {}
+	inline indexer(sign_t sign, const indexer& i) : indexer(i) { name = sign; }
 
 	sign_t name;
 	mapper map;
+	binder bind; // for indexers created at runtime, e.g., custom patterns
+	const void* args;
 };
 
 class feature {
@@ -546,8 +801,8 @@ public:
 	static inline cache& instance() { static cache tp; return tp; }
 
 private:
-	static inline block* alloc(size_t len) { return shm::enable<block>() ? shm::alloc<block>(len) : new block[len](); }
-	static inline void free(block* alloc) { shm::enable<block>() ? shm::free<block>(alloc) : delete[] alloc; }
+	static inline block* alloc(size_t len) { return shm::enable<block>() ? shm::alloc<block>(len) : page::alloc<block>(len); }
+	static inline void free(block* alloc) { shm::enable<block>() ? shm::free<block>(alloc) : page::free<block>(alloc); }
 
 	cache& init(size_t len, bool peek = false) {
 		length = (1ull << (math::lg64(len)));
@@ -705,29 +960,128 @@ u64 indexmax(const board& b) { // 16-bit
 	return k.mask(k.max());
 }
 
-struct adapter {
-	typedef moporgic::list<indexer::mapper> adapter_list;
-	typedef moporgic::list<std::function<u64(const board&)>> indexer_list;
-	static inline adapter_list& wlist() { static adapter_list w; return w; }
-	static inline indexer_list& hlist() { static indexer_list h; return h; }
+struct pattern { // table-driven indexer for custom patterns, indexes with a single pext or pshufb
+	u64 mask;
+	u32 size;
+	u32 base; // tiles not less than base - 1 share the same slot, i.e., base^size entries if capped
+	bool ordered;
+	alignas(16) u8 perm[16];
+
+	inline u64 operator ()(const board& b) const {
+#if defined(__BMI2__) && !defined(PREFER_LEGACY_INDEXPT_ORDER)
+		if (ordered) return math::pext64(b, mask);
+#endif
+#if defined(__SSSE3__)
+		__m128i x = _mm_cvtsi64_si128(u64(b)), lo = _mm_set1_epi8(0x0f);
+		x = _mm_unpacklo_epi8(_mm_and_si128(x, lo), _mm_and_si128(_mm_srli_epi16(x, 4), lo)); // cell i in byte i
+		x = _mm_shuffle_epi8(x, _mm_load_si128(pointer_cast<__m128i>(perm)));
+		x = _mm_maddubs_epi16(x, _mm_set1_epi16(0x1001));
+		return _mm_cvtsi128_si64(_mm_packus_epi16(x, x));
+#else
+		u64 index = 0;
+		for (u32 i = 0; i < size; i++) index |= u64(b.at(perm[i])) << (i << 2);
+		return index;
+#endif
+	}
 
-	inline operator indexer::mapper() const { return wlist().front(); }
-	inline adapter(std::function<u64(const board&)> hdr) { hlist().push_back(hdr); }
-	inline ~adapter() { wlist().pop_front(); }
+	inline u64 capped(const board& b) const {
+#if defined(__SSSE3__)
+		__m128i x = _mm_cvtsi64_si128(u64(b)), lo = _mm_set1_epi8(0x0f);
+		x = _mm_unpacklo_epi8(_mm_and_si128(x, lo), _mm_and_si128(_mm_srli_epi16(x, 4), lo)); // cell i in byte i
+		x = _mm_shuffle_epi8(_mm_min_epu8(x, _mm_set1_epi8(base - 1)), _mm_load_si128(pointer_cast<__m128i>(perm)));
+		x = _mm_maddubs_epi16(x, _mm_set1_epi16((base << 8) | 1)); // 2 digits per word, at most 15 + 15 * 15
+		x = _mm_madd_epi16(x, _mm_set1_epi32((base * base) << 16 | 1)); // 4 digits per dword, at most 15^4 - 1
+		u64 w = _mm_cvtsi128_si64(x), v = _mm_cvtsi128_si64(_mm_unpackhi_epi64(x, x)), b4 = base * base * base * base;
+		return u32(w) + (w >> 32) * b4 + (u32(v) + (v >> 32) * b4) * b4 * b4;
+#else
+		u64 index = 0;
+		for (u32 i = size; i; i--) index = index * base + std::min<u32>(b.at(perm[i - 1]), base - 1);
+		return index;
+#endif
+	}
 
-	template<u32 idx>
-	static u64 adapt(const board& b) { return hlist()[idx](b); }
+	static u64 ordered_index(const board& b, const void* x) { return math::pext64(b, pointer_cast<pattern>(x)->mask); }
+	static u64 shuffle_index(const board& b, const void* x) { return (*pointer_cast<pattern>(x))(b); }
+	static u64 capped_index(const board& b, const void* x) { return pointer_cast<pattern>(x)->capped(b); }
 
-	template<u32 idx, u32 lim>
-	static void make() { make_wrappers<idx, lim>(); }
+	static inline std::deque<pattern>& plist() { static std::deque<pattern> p; return p; } // never relocated
 
-	template<u32 idx, u32 lim>
-	struct make_wrappers {
-		make_wrappers() { wlist().push_back(adapter::adapt<idx>); }
-		~make_wrappers() { make_wrappers<idx + 1, lim>(); }
-	};
-	template<u32 lim>
-	struct make_wrappers<lim, lim> {};
+	static indexer& make(indexer::sign_t sign, const std::vector<u32>& p, u32 base = 16) {
+		pattern& x = plist().emplace_back();
+		x.mask = 0, x.size = std::min<u32>(p.size(), 16), x.base = base, x.ordered = true;
+		std::fill_n(x.perm, 16, 0x80);
+		for (u32 i = 0; i < x.size; i++) {
+			x.mask |= 0xfull << (p[i] << 2);
+			x.perm[i] = p[i];
+			if (i && p[i] <= p[i - 1]) x.ordered = false;
+		}
+		if (x.base < 16) return indexer::make(sign, capped_index, &x);
+#if defined(__BMI2__) && !defined(PREFER_LEGACY_INDEXPT_ORDER)
+		if (x.ordered) return indexer::make(sign, ordered_index, &x);
+#endif
+		return indexer::make(sign, shuffle_index, &x);
+	}
+};
+
+struct symmetric { // canonical indexer for self-symmetric patterns, folds mirrored indexes into one slot
+	u32 npair, nfix;
+	u8 pair[8][2], fix[16]; // cells swapped by the mirror, and cells fixed by the mirror
+	u64 untied[8], tied[8]; // strides of a pair at each level, when the cells are different or equal
+
+	inline u64 operator ()(const board& b) const {
+		u64 index = 0, rest = 0;
+		for (u32 j = 0; j < npair; j++) {
+			u32 u = b.at(pair[j][0]), v = b.at(pair[j][1]);
+			if (u == v) { // tied, the canonical order depends on the remaining pairs
+				index += 120 * untied[j] + u * tied[j];
+				continue;
+			}
+			u32 m = u < v ? 0 : 1; // take the mirror if the first untied pair is descending
+			if (m) std::swap(u, v);
+			for (u32 k = j + 1; k < npair; k++) rest = (rest << 8) | (b.at(pair[k][m]) << 4) | b.at(pair[k][m ^ 1]);
+			for (u32 k = 0; k < nfix; k++) rest = (rest << 4) | b.at(fix[k]);
+			return index + (u * (31 - u) / 2 + v - u - 1) * untied[j] + rest;
+		}
+		for (u32 k = 0; k < nfix; k++) rest = (rest << 4) | b.at(fix[k]);
+		return index + rest;
+	}
+
+	u64 init(const std::vector<u32>& p) { // returns the canonical size, or 0 if p is not self-symmetric
+		npair = nfix = 0;
+		if (p.size() < 2 || p.size() > 12) return 0;
+		for (u32 iso = 1; iso < 8 && npair == 0; iso++) {
+			board x(0xfedcba9876543210ull); x.isom((iso & 4) + (8 - iso) % 4);
+			std::vector<u32> mirror;
+			for (u32 cell : p) mirror.push_back(std::find(p.begin(), p.end(), x.at(cell)) - p.begin());
+			bool involution = true;
+			for (u32 i = 0; i < p.size(); i++) involution &= mirror[i] < p.size() && mirror[mirror[i]] == i;
+			if (!involution) continue;
+			for (u32 i = 0; i < p.size(); i++) {
+				if (mirror[i] > i) pair[npair][0] = p[i], pair[npair][1] = p[mirror[i]], npair++;
+				if (mirror[i] == i) fix[nfix++] = p[i];
+			}
+			if (npair == 0) nfix = 0;
+		}
+		if (npair == 0) return 0;
+		u64 size = 1ull << (nfix << 2);
+		for (u32 j = npair; j; j--) {
+			untied[j - 1] = 1ull << ((nfix + 2 * (npair - j)) << 2);
+			tied[j - 1] = size;
+			size = 120 * untied[j - 1] + 16 * tied[j - 1];
+		}
+		return size;
+	}
+
+	static u64 fold(const std::vector<u32>& p) { symmetric x; return x.init(p); }
+	static u64 canonical_index(const board& b, const void* x) { return (*pointer_cast<symmetric>(x))(b); }
+
+	static inline std::deque<symmetric>& slist() { static std::deque<symmetric> s; return s; } // never relocated
+
+	static indexer& make(indexer::sign_t sign, const std::vector<u32>& p) {
+		symmetric& x = slist().emplace_back();
+		x.init(p);
+		return indexer::make(sign, canonical_index, &x);
+	}
 };
 
 struct make {
@@ -846,8 +1200,6 @@ __attribute__((constructor)) void init() {
 	make("max#5", indexmax<5>);
 	make("max#6", indexmax<6>);
 	make("max#7", indexmax<7>);
-
-	adapter::make<0, 256>();
 }
 
 } // namespace utils
@@ -1030,30 +1382,52 @@ void config_random(utils::options::option opt) {
 	moporgic::srand(to_hash(opt.value("moporgic")));
 }
 
-void config_memory(utils::options::option opt) {
+void config_memory(utils::options::option opt, utils::options::option ext = {}) {
+	page::policy(ext["alloc"].value("normal"));
+	weight::sparse() = ext("sparse");
 	shm::enable(shm::support() && !opt("noshm") && (opt("shm") || opt.value(1) > 1));
 	shm::enable<weight::segment>(shm::enable() && !opt("noshm:weight") && (opt("shm") || opt("shm:weight") || opt("optimize")));
+	if (weight::sparse() && shm::enable<weight::segment>()) // SysV segments commit a page on the first read of a hole
+		std::cerr << "warning: sparse SHM tables also commit the pages that are only read" << std::endl;
 	shm::enable<cache::block>(shm::enable() && !opt("noshm:cache") && (opt("shm") || opt("shm:cache") || opt("evaluate")));
 }
 
-void config_weight(utils::options::option opt) {
+void config_weight(utils::options::option opt, utils::options::option ext = {}) {
 	u32 code = weight::type(), last = code;
 	opt += ("alpha=" + opt);
 	if (opt["alpha"].value(0.0 / 0.0) <  1.0) code = weight::structure::code;
 	if (opt["alpha"].value(0.0 / 0.0) >= 1.0) code = weight::coherence::code;
 	if (opt["alpha"]("fix")) code = weight::structure::code;
+	if (opt["alpha"]("f16")) code = weight::float16::code;
+	if (opt["alpha"]("bf16")) code = weight::bfloat16::code;
 	if (opt["alpha"]("coh")) code = weight::coherence::code;
+	if (opt("quantize") || ext("quantize")) code = weight::quantized::code;
 	if (weight::type(code) == last || weight::wghts().empty()) return;
 
+	auto visit = [](weight w, u32 code, auto func) {
+		switch (code) {
+		default:
+		case weight::structure::code: func(w.value<weight::structure>()); break;
+		case weight::coherence::code: func(weight::coherence::view{ w.data<weight::coherence>() }); break;
+		case weight::float16::code: func(w.value<weight::float16>()); break;
+		case weight::bfloat16::code: func(w.value<weight::bfloat16>()); break;
+		}
+	};
 	weight::container wbuf(std::move(weight::wghts()));
-	for (weight u, w; wbuf.size(); wbuf.erase(u.sign())) { // format existing weights into new scheme
+	for (weight u; wbuf.size(); wbuf.erase(u.sign())) { // format existing weights into new scheme
 		u = wbuf.front();
-		w = weight::make(u.sign(), u.size());
-		switch (code) {
-		case weight::structure::code: std::copy_n(u.data<weight::coherence::unit<0>>(), u.size(), w.data<weight::structure>()); break;
-		case weight::coherence::code: std::copy_n(u.data<weight::structure>(), u.size(), w.data<weight::coherence::unit<0>>()); break;
+		weight& w = weight::make(u.sign(), u.size());
+		if (code == weight::quantized::code) {
+			visit(u, last, [&](auto src) { w.quantize([&](size_t i) { return numeric(src[i]); }); });
+		} else if (last == weight::quantized::code) {
+			visit(w, code, [&](auto dst) { for (size_t i = 0; i < u.size(); i++) dst[i] = u.at<weight::quantized>(i).value * u.unit(); });
+		} else {
+			visit(u, last, [&](auto src) {
+				visit(w, code, [&](auto dst) { for (size_t i = 0; i < u.size(); i++) if (numeric(src[i]) != 0) dst[i] = numeric(src[i]); });
+			});
 		}
 	}
+	if (code == weight::quantized::code) weight::unify();
 	for (feature f : feature::container(std::move(feature::feats()))) { // bind features and weights
 		feature::make(f.value().sign(), f.index().sign());
 	}
@@ -1064,22 +1438,69 @@ statistic invoke(statistic(*run)(option), option opt) {
 	if (opt("alpha")) config_weight(opt);
 	if (opt("search", "refresh")) cache::refresh();
 	u32 thdnum = opt["thread"].value(1), thdid = thdnum;
+	moporgic::random::engine seed = moporgic::random::state(); // workers jump their streams from this state
+	// spread workers over nodes, evaluation replicates weights per node (SHM only), otherwise interleaves pages
+	u32 nodes = opt["thread"]("numa") ? std::min<u32>(numa::count(), thdnum) : 1;
+	bool evaluate = std::string(opt["mode"]).find("evaluate") == 0;
+	bool optimize = std::string(opt["mode"]).find("optimize") == 0;
+	if (nodes > 1 && optimize && opt["thread"]("numa=replica")) // replicas are private copies, so updates on other nodes would be lost
+		std::cerr << "warning: numa=replica is ignored since the network is being trained" << std::endl;
+	bool replica = nodes > 1 && shm::enable() && !optimize && !weight::sparse() && (opt["thread"]("numa=replica") || (evaluate && !opt["thread"]("numa=interleave")));
+	std::vector<weight::container> replicas(replica ? nodes : 0);
+	// workers claim episodes from a shared counter instead of a static split if scheduled dynamically
+	if (thdnum > 1 && opt["thread"]("dynamic")) statistic::share(opt);
+	for (u32 node = 1; node < replicas.size(); node++) {
+		for (weight w : weight::wghts()) {
+			void* data = numa::alloc(w.bytes(), node);
+			std::memcpy(data, w.data(), w.bytes());
+			replicas[node].push_back(w.rebind(data));
+		}
+	}
+	if (nodes > 1) {
+		for (weight w : weight::wghts())
+			replica ? numa::place(w.data(), w.bytes(), 0) : numa::interleave(w.data(), w.bytes());
+		numa::interleave(&cache::instance()[0], cache::instance().size() * sizeof(cache::block));
+	}
+	auto bind = [&](u32 thdid) {
+		if (nodes == 1) return;
+		u32 node = u64(thdid) * nodes / thdnum;
+		numa::bind(node);
+		if (node == 0 || replicas.empty()) return;
+		for (size_t i = 0; i < weight::wghts().size(); i++) weight::wghts()[i] = replicas[node][i];
+		for (feature f : feature::container(std::move(feature::feats()))) { // bind features and local replicas
+			feature::make(f.value().sign(), f.index().sign());
+		}
+	};
+	auto unbind = [&]() {
+		if (nodes == 1) return;
+		numa::reset();
+		for (weight::container& replica : replicas)
+			for (weight w : replica) numa::free(w.data(), w.bytes());
+	};
 #if defined(__linux__)
 	if (shm::enable()) {
 		statistic* stats = shm::alloc<statistic>(thdnum);
 		while ((opt["thread#"] = (--thdid)).value(0) && fork());
+		bind(thdid);
 		statistic stat = stats[thdid] = run(opt);
 		if (thdid == 0) while (wait(nullptr) > 0); else std::quick_exit(0);
 		for (u32 i = 1; i < thdnum; i++) stat += stats[i];
 		shm::free(stats);
+		statistic::unshare();
+		unbind();
+		moporgic::random::state(seed), moporgic::random::long_jump(); // skip over the streams just used
 		return stat;
 	}
 #endif
 	std::list<std::future<statistic>> thdpool;
 	while ((opt["thread#"] = (--thdid)).value(0))
-		thdpool.push_back(std::async(std::launch::async, run, opt));
+		thdpool.push_back(std::async(std::launch::async, [=]() { moporgic::random::state(seed); bind(thdid); return run(opt); }));
+	bind(thdid);
 	statistic stat = run(opt);
 	for (std::future<statistic>& thd : thdpool) stat += thd.get();
+	statistic::unshare();
+	unbind();
+	moporgic::random::state(seed), moporgic::random::long_jump(); // skip over the streams just used
 	return stat;
 }
 
@@ -1107,8 +1528,8 @@ std::string resolve(const std::string& token) {
 	case to_hash("4x5patt/41-32"):       return "01234 45678 01245 45689 ";
 	case to_hash("2x4patt/4"):           return "0123 4567 ";
 	case to_hash("5x4patt/4-22"):        return resolve("2x4patt/4") + "0145 1256 569a ";
-	case to_hash("8x4patt/legacy"):      return "0123:0123 4567:4567 89ab:89ab cdef:cdef 048c:048c 159d:159d 26ae:26ae 37bf:37bf ";
-	case to_hash("9x4patt/legacy"):      return "0145:0145 1256:1256 2367:2367 4589:4589 569a:569a 67ab:67ab 89cd:89cd 9ade:9ade abef:abef ";
+	case to_hash("8x4patt/legacy"):      return "0123[~]:0123 4567[~]:4567 89ab[~]:89ab cdef[~]:cdef 048c[~]:048c 159d[~]:159d 26ae[~]:26ae 37bf[~]:37bf ";
+	case to_hash("9x4patt/legacy"):      return "0145[~]:0145 1256[~]:1256 2367[~]:2367 4589[~]:4589 569a[~]:569a 67ab[~]:67ab 89cd[~]:89cd 9ade[~]:9ade abef[~]:abef ";
 	case to_hash("1x8patt/44"):          return "01234567 ";
 	case to_hash("2x8patt/44"):          return "01234567 456789ab ";
 	case to_hash("3x8patt/44-332"):      return resolve("2x8patt/44") + "01245689 ";
@@ -1135,7 +1556,8 @@ std::string resolve(const std::string& token) {
 void make_network(utils::options::option opt) {
 	std::string tokens = opt;
 	if (tokens.empty() && feature::feats().empty()) {
-		for (weight w : weight::wghts()) tokens += (w.sign() + ' ');
+		for (weight w : weight::wghts()) // ~ keeps the loaded size, e.g., canonical or capped tables
+			tokens += (w.sign() + (w.sign().find_first_not_of("0123456789abcdef") == std::string::npos ? "[~] " : " "));
 		if (tokens.empty()) tokens = "default";
 	}
 
@@ -1207,10 +1629,9 @@ void make_network(utils::options::option opt) {
 	std::stringstream unisomorphic(tokens); tokens.clear();
 	for (std::string token; unisomorphic >> token; tokens += (token + ' ')) {
 		if (token.find('!') == npos) {
-			std::string name = token.substr(0, token.find_first_of("&|="));
-			if (name.find_first_not_of("0123456789abcdef") == npos && token.find(':') == npos)
-				token += ':' + name + '!';
-			else continue;
+			std::string name = token.substr(0, token.find_first_of("&|=[("));
+			if (name.find_first_not_of("0123456789abcdef") != npos || token.find(':') != npos) continue;
+			token += ':' + name + '!';
 		}
 		std::vector<std::string> lvals, rvals;
 		lvals.push_back(token.substr(0, token.find(':')));
@@ -1269,6 +1690,14 @@ void make_network(utils::options::option opt) {
 				size = std::pow(base, power);
 			} else if (info.find_first_not_of("0123456789.-x") == npos) {
 				size = std::stoull(info, nullptr, 0);
+			} else if (info.find('~') != npos) { // ~ canonical table for self-symmetric patterns, unless a table is loaded
+				auto it = std::find_if(weight::wghts().begin(), weight::wghts().end(), [=](weight w) { // 0123 <--> 00000123
+					std::string id = w.sign();
+					return id.size() >= name.size() && id.find_first_not_of('0') >= id.size() - name.size()
+						&& id.substr(id.size() - name.size()) == name;
+				});
+				size = it != weight::wghts().end() ? it->size() : index::symmetric::fold(stov(name));
+				if (!size) size = std::pow(16, name.size()); // not self-symmetric
 			}
 			if (init.find_first_of("{}") != npos && init != "{}") {
 				weight src(init.substr(0, init.find('}')).substr(init.find('{') + 1));
@@ -1284,30 +1713,39 @@ void make_network(utils::options::option opt) {
 				if (test.size() == size) raw_cast<std::string>(weight::wghts().at(test.sign())) = sign; // unsafe!
 			}
 			if (!weight(sign) && size) { // create new weight table
-				weight dst = weight::make(sign, size);
+				weight& dst = weight::make(sign, size);
 				if (init.find_first_of("{}") != npos && init != "{}") { // copy from existing table
 					weight src(init.substr(0, init.find('}')).substr(init.find('{') + 1));
 					switch (weight::type()) {
 					default:
 					case weight::structure::code: std::copy_n(src.data<weight::structure>(), src.size(), dst.data<weight::structure>()); break;
-					case weight::coherence::code: std::copy_n(src.data<weight::coherence>(), src.size(), dst.data<weight::coherence>()); break;
+					case weight::coherence::code: std::copy_n(src.data<numeric>(), src.bytes() / sizeof(numeric), dst.data<numeric>()); break;
+					case weight::float16::code: std::copy_n(src.data<weight::float16>(), src.size(), dst.data<weight::float16>()); break;
+					case weight::bfloat16::code: std::copy_n(src.data<weight::bfloat16>(), src.size(), dst.data<weight::bfloat16>()); break;
+					case weight::quantized::code: dst.quantize([&](size_t i) { return src.at<weight::quantized>(i).value * src.unit(); }); break;
 					}
 				} else if (init.find_first_of("0123456789.+-") == 0) { // initialize with specific value
 					numeric val = std::stod(init) * (init.find("norm") != npos ? std::pow(num, -1) : 1);
 					switch (weight::type()) {
 					default:
 					case weight::structure::code: std::fill_n(dst.data<weight::structure>(), dst.size(), val); break;
-					case weight::coherence::code: std::fill_n(dst.data<weight::coherence>(), dst.size(), val); break;
+					case weight::coherence::code: for (size_t i = 0; i < dst.size(); i++) dst.at<weight::coherence>(i) = val; break;
+					case weight::float16::code: std::fill_n(dst.data<weight::float16>(), dst.size(), val); break;
+					case weight::bfloat16::code: std::fill_n(dst.data<weight::bfloat16>(), dst.size(), val); break;
+					case weight::quantized::code: dst.quantize([=](size_t i) { return val; }); break;
 					}
 				}
 			} else if (weight(sign) && size) { // table already exists
-				weight dst = weight(sign);
+				weight& dst = weight::wghts()[sign];
 				if (init.find_first_of("+-") == 0) { // adjust with specific value
 					numeric off = std::stod(init) * (init.find("norm") != npos ? std::pow(num, -1) : 1);
 					switch (weight::type()) {
 					default:
 					case weight::structure::code: for (numeric& val : dst.value<weight::structure>()) val += off; break;
-					case weight::coherence::code: for (numeric& val : dst.value<weight::coherence>()) val += off; break;
+					case weight::coherence::code: for (size_t i = 0; i < dst.size(); i++) dst.at<weight::coherence>(i).value += off; break;
+					case weight::float16::code: for (weight::float16& val : dst.value<weight::float16>()) val = val + off; break;
+					case weight::bfloat16::code: for (weight::bfloat16& val : dst.value<weight::bfloat16>()) val = val + off; break;
+					case weight::quantized::code: dst.quantize([&](size_t i) { return dst.at<weight::quantized>(i).value * dst.unit() + off; }); break;
 					}
 				}
 			}
@@ -1324,24 +1762,34 @@ void make_network(utils::options::option opt) {
 				ss << std::hex << std::setfill('0') << std::setw(8) << ((std::stoull(name, nullptr, 16) & mska) | msko);
 				ss.str();
 			});
-			if (!indexer(sign)) {
-				indexer::mapper index = indexer(name).index();
-				if (!index) index = index::adapter(std::bind(index::indexptv, std::placeholders::_1, stov(name)));
-				indexer::make(sign, index);
+			u32 base = 16; // capped alphabet: weight[13^6] indexed by 012345 --> tiles 4096 and above share a slot
+			if (wght.size() && sign == name && name.find_first_not_of("0123456789abcdef") == npos && name.size() < 16)
+				while (base > 2 && std::pow(base, name.size()) > weight(wght).size()) base--;
+			if (sign == name && index::symmetric::fold(stov(name)) == weight(wght).size() && weight(wght).size()) {
+				sign = name + '~';
+				if (!indexer(sign)) index::symmetric::make(sign, stov(name));
+			} else if (base < 16 && std::pow(base, name.size()) == weight(wght).size()) {
+				sign = name + '^' + std::to_string(base);
+				if (!indexer(sign)) index::pattern::make(sign, stov(name), base);
+			} else if (!indexer(sign)) {
+				if (indexer(name)) indexer::make(sign, indexer(name));
+				else index::pattern::make(sign, stov(name));
 			}
 			idxr = indexer(sign).sign();
 		}
 
 		if (wght.size() && idxr.size() && !feature(wght, idxr)) feature::make(wght, idxr);
 	}
+	if (weight::type() == weight::quantized::code) weight::unify();
 }
-void load_network(utils::options::option files) {
+void load_network(utils::options::option files, utils::options::option ext = {}) {
 	list<weight::segment*> fixed;
 	for (std::string file : files) {
 		std::string path = file.substr(file.find('|') + 1);
 		std::string opt = path != file ? file.substr(0, file.find('|')) : "";
 		std::ifstream in;
 		in.open(path, std::ios::in | std::ios::binary);
+		weight::mapping() = ext("mmap") ? path : "";
 		while (in.peek() != -1) {
 			char type = in.peek();
 			if (type != 0) { // new binaries already store its type, so use it for the later loading
@@ -1358,6 +1806,7 @@ void load_network(utils::options::option files) {
 		}
 		in.close();
 	}
+	weight::mapping() = {};
 	weight::container& wghts = weight::wghts();
 	weight::container final, merge;
 	std::map<std::string, size_t> numof;
@@ -1381,10 +1830,26 @@ void load_network(utils::options::option files) {
 			case weight::coherence::code:
 				for (size_t i = 0; i < m.size(); i++) {
 					m.at<weight::coherence>(i).value += w.at<weight::coherence>(i).value; // will be divided later
-					m.at<weight::coherence>(i).accum += w.at<weight::coherence>(i).accum;
-					m.at<weight::coherence>(i).updvu += w.at<weight::coherence>(i).updvu;
+					m.at<weight::coherence>(i).accum() += w.at<weight::coherence>(i).accum();
+					m.at<weight::coherence>(i).updvu() += w.at<weight::coherence>(i).updvu();
 				}
 				break;
+			case weight::float16::code: // average progressively, since the sum may overflow
+				for (size_t i = 0, n = numof[w.sign()] + 1; i < m.size(); i++)
+					m.at<weight::float16>(i) = m.at<weight::float16>(i) + (w.at<weight::float16>(i) - m.at<weight::float16>(i)) / n;
+				break;
+			case weight::bfloat16::code:
+				for (size_t i = 0, n = numof[w.sign()] + 1; i < m.size(); i++)
+					m.at<weight::bfloat16>(i) = m.at<weight::bfloat16>(i) + (w.at<weight::bfloat16>(i) - m.at<weight::bfloat16>(i)) / n;
+				break;
+			case weight::quantized::code: // average progressively, then requantize with a new scale
+				m.quantize([&, n = numof[w.sign()] + 1](size_t i) {
+					numeric mv = m.at<weight::quantized>(i).value * m.unit(), wv = w.at<weight::quantized>(i).value * w.unit();
+					return mv + (wv - mv) / n;
+				});
+				for (weight& x : final) if (x.data() == m.data()) x.unit() = m.unit();
+				for (weight& x : merge) if (x.data() == m.data()) x.unit() = m.unit();
+				break;
 			}
 			wghts.erase(w.sign()); // free this duplicated weight
 			numof[w.sign()] += 1;
@@ -1396,19 +1861,24 @@ void load_network(utils::options::option files) {
 		switch (weight::type()) {
 		default:
 		case weight::structure::code: for (weight::structure& s : m.value<weight::structure>()) s.value /= n; break;
-		case weight::coherence::code: for (weight::coherence& c : m.value<weight::coherence>()) c.value /= n; break;
+		case weight::coherence::code: for (size_t i = 0; i < m.size(); i++) m.at<weight::coherence>(i).value /= n; break;
+		case weight::float16::code: break; // already averaged
+		case weight::bfloat16::code: break;
+		case weight::quantized::code: break;
 		}
 	}
 	wghts.swap(final);
 }
-void save_network(utils::options::option files) {
+void save_network(utils::options::option files, utils::options::option ext = {}, const std::string& temp = {}) {
+	weight::paged() = ext("mmap");
 	for (std::string file : files) {
 		std::string path = file.substr(file.find('|') + 1);
 		std::string opt = path != file ? file.substr(0, file.find('|')) : "";
 		char type = path[path.find_last_of(".") + 1];
 		if (type == 'x' || type == 'l') continue; // .x and .log are suffix for log files
+		if (ext("mmap")) std::remove(path.c_str()); // keep the old contents for existing mappings
 		std::ofstream out;
-		out.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+		out.open(path + temp, std::ios::out | std::ios::binary | std::ios::trunc);
 		if (!out.is_open()) continue;
 		// for upward compatibility, we still write legacy binaries for traditional suffixes
 		if (type != 'c') { // .w is reserved for weights binary
@@ -1417,9 +1887,49 @@ void save_network(utils::options::option files) {
 			cache::save(type != 'c' ?  out.write("c", 1) : out, opt);
 		}
 		out.close();
+		if (temp.size()) std::rename((path + temp).c_str(), path.c_str()); // replace the file only if completed
 	}
 }
 
+struct checkpoint { // periodic saving during training, e.g., -x checkpoint=every:10 saves every 10 units
+	static inline utils::options::option& files() { static utils::options::option files; return files; }
+	static inline utils::options::option& ext() { static utils::options::option ext; return ext; }
+	static inline u64& every() { static u64 every = 0; return every; }
+	static inline int& pid() { static int pid = 0; return pid; }
+
+	static void config(utils::options::option files, utils::options::option ext = {}) {
+		std::string conf = ext["checkpoint"].value("");
+		every() = std::stoull("0" + conf.substr(conf.find(':') + 1));
+		checkpoint::files() = files;
+		checkpoint::ext() = ext;
+	}
+	/**
+	 * save the network to the output files from a forked process, so that training continues meanwhile
+	 * the forked process sees a copy-on-write snapshot of private tables, while SHM tables are saved as they are updated
+	 */
+	static inline bool due(u64 unit) { return every() && unit % every() == 0; }
+	static void save(u64 unit) {
+		if (!due(unit)) return;
+#if defined(__linux__)
+		if (pid() > 0 && waitpid(pid(), nullptr, WNOHANG) == 0) return; // the last one is still being saved
+		if ((pid() = fork()) != 0) return;
+		save_network(files(), ext(), ".tmp");
+		std::quick_exit(0);
+#else
+		save_network(files(), ext(), ".tmp");
+#endif
+	}
+	/**
+	 * wait for the ongoing checkpoint, e.g., before saving the final network
+	 */
+	static void wait() {
+#if defined(__linux__)
+		if (pid() > 0) waitpid(pid(), nullptr, 0);
+#endif
+		pid() = 0;
+	}
+};
+
 void list_network() {
 	if (weight::wghts().empty()) return;
 
@@ -1432,6 +1942,8 @@ void list_network() {
 		buf << (w.size() / std::pow(2, p * 10));
 		buf << ("\0\0k\0M\0G\0T\0" + (p << 1));
 		buf << "]";
+		if (weight::sparse()) // the touched ratio of lazily committed tables
+			buf << " " << std::fixed << std::setprecision(2) << (100.0 * w.touched() / (w.bytes() ?: 1)) << "%";
 
 		buf << " :";
 		std::ios::pos_type pos = buf.tellp();
@@ -1452,10 +1964,12 @@ void list_network() {
 struct method {
 	typedef numeric(*estimator)(const board&, clip<feature>);
 	typedef numeric(*optimizer)(const board&, numeric, clip<feature>);
+	typedef void(*locator)(const board&, clip<feature>);
 
 	estimator estim;
 	optimizer optim;
-	constexpr inline method(estimator estim = estimate, optimizer optim = optimize) : estim(estim), optim(optim) {}
+	locator fetch;
+	constexpr inline method(estimator estim = estimate, optimizer optim = optimize, locator fetch = locate) : estim(estim), optim(optim), fetch(fetch) {}
 	constexpr inline operator estimator() const { return estim; }
 	constexpr inline operator optimizer() const { return optim; }
 
@@ -1471,10 +1985,14 @@ struct method {
 			esti += (feat[state] += error);
 		return esti;
 	}
+	constexpr static inline void locate(const board& state, clip<feature> range = feature::feats()) {
+		for (feature& feat : range)
+			__builtin_prefetch(&feat[state], 0);
+	}
 
 	template<typename mode = weight::segment>
 	struct common {
-		constexpr inline operator method() { return { common<mode>::estimate, common<mode>::optimize }; }
+		constexpr inline operator method() { return { common<mode>::estimate, common<mode>::optimize, common<mode>::locate }; }
 
 		constexpr static inline numeric estimate(const board& state, clip<feature> range = feature::feats()) {
 			numeric esti = 0;
@@ -1488,11 +2006,49 @@ struct method {
 				esti += (feat.at<mode>(state) += error);
 			return esti;
 		}
+		constexpr static inline void locate(const board& state, clip<feature> range = feature::feats()) {
+			for (feature& feat : range)
+				__builtin_prefetch(&feat.at<mode>(state), 0);
+		}
+
+		typedef common simd; // no vectorized kernel for arbitrary features
+		typedef common fused; // no fused indexer for arbitrary features
+		typedef common permute; // no isomorphism for arbitrary features
+
+		struct prefetch { // locate and prefetch a block of weights first, then access them
+			constexpr inline operator method() { return { prefetch::estimate, prefetch::optimize, common::locate }; }
+			static constexpr u32 block = 64;
+
+			constexpr static inline numeric estimate(const board& state, clip<feature> range = feature::feats()) {
+				numeric esti = 0;
+				mode* wptr[block];
+				for (feature* feat = range.begin(); feat != range.end(); ) {
+					u32 n = 0;
+					for (; feat != range.end() && n < block; feat++, n++)
+						__builtin_prefetch(wptr[n] = &feat->at<mode>(state), 0);
+					for (u32 i = 0; i < n; i++)
+						esti += *wptr[i];
+				}
+				return esti;
+			}
+			constexpr static inline numeric optimize(const board& state, numeric error, clip<feature> range = feature::feats()) {
+				numeric esti = 0;
+				mode* wptr[block];
+				for (feature* feat = range.begin(); feat != range.end(); ) {
+					u32 n = 0;
+					for (; feat != range.end() && n < block; feat++, n++)
+						weight::prefetch<1>(wptr[n] = &feat->at<mode>(state));
+					for (u32 i = 0; i < n; i++)
+						esti += (*wptr[i] += error);
+				}
+				return esti;
+			}
+		};
 	};
 
 	template<typename mode = weight::segment>
 	struct isomorphic {
-		constexpr inline operator method() { return { isomorphic::estimate, isomorphic::optimize }; }
+		constexpr inline operator method() { return { isomorphic::estimate, isomorphic::optimize, isomorphic::locate }; }
 
 		constexpr static inline_always numeric invoke(const board& iso, clip<feature> f) {
 			numeric esti = 0;
@@ -1536,10 +2092,158 @@ struct method {
 			return esti;
 		}
 
+		constexpr static inline_always void isoms(const board& state, board iso[]) {
+			iso[0] = state;
+			iso[1] = ({ board x = iso[0]; x.flip();      x; });
+			iso[2] = ({ board x = iso[1]; x.transpose(); x; });
+			iso[3] = ({ board x = iso[2]; x.flip();      x; });
+			iso[4] = ({ board x = iso[3]; x.transpose(); x; });
+			iso[5] = ({ board x = iso[4]; x.flip();      x; });
+			iso[6] = ({ board x = iso[5]; x.transpose(); x; });
+			iso[7] = ({ board x = iso[6]; x.flip();      x; });
+		}
+
+		constexpr static inline void locate(const board& state, clip<feature> range = feature::feats()) {
+			board iso[8];
+			isoms(state, iso);
+			for (feature* feat = range.begin(); feat != range.end(); feat += 8)
+				for (u32 i = 0; i < 8; i++)
+					__builtin_prefetch(&feat->at<mode>(iso[i]), 0);
+		}
+
+		typedef isomorphic simd; // no vectorized kernel for dynamic patterns
+		typedef isomorphic fused; // no fused indexer for dynamic patterns
+
+#if defined(__SSSE3__) && !defined(PREFER_SCALAR_INDEX)
+		struct permute { // index the isomorphisms by permuting the cells of the original board, instead of transforming it
+			constexpr inline operator method() { return { permute::estimate, permute::optimize, isomorphic::locate }; }
+
+			struct table {
+				struct alignas(16) control { u8 cell[16]; };
+				const feature* begin = nullptr;
+				const feature* end = nullptr;
+				bool valid = false;
+				std::vector<control> ctrl; // [pattern * 8 + isomorphism]
+
+				table() = default;
+				table(clip<feature> range) : begin(range.begin()), end(range.end()), valid(true) {
+					board iso = 0xfedcba9876543210ull, cell[8];
+					for (u32 j = 0; j < 8; j++) { // same chain as isomorphic::estimate: flip, transpose, flip, ...
+						cell[j] = iso;
+						if (j & 1) iso.transpose(); else iso.flip();
+					}
+					moporgic::xoshiro256ss gen; // not to disturb the random streams of games
+					for (feature* feat = range.begin(); feat != range.end() && valid; feat += 8) {
+						control base;
+						std::fill_n(base.cell, 16, 0x80);
+						for (u32 c = 0; c < 16; c++) { // probe the cells, the indexer must be a pattern
+							u64 t = (*feat)(board(1ull << (c << 2)));
+							if (t && (t & (t - 1) || math::tzcnt64(t) & 3)) valid = false;
+							if (t) base.cell[math::tzcnt64(t) >> 2] = c;
+						}
+						for (u32 j = 0; j < 8; j++) {
+							control x = base;
+							for (u8& c : x.cell) c = c < 16 ? cell[j].at(c) : c;
+							ctrl.push_back(x);
+						}
+						for (u32 k = 0; k < 16 && valid; k++) { // verify with some random boards
+							board b = gen() & 0x7777777777777777ull;
+							valid = invoke(index(b), ctrl[ctrl.size() - 8]) == (*feat)(b);
+						}
+					}
+				}
+			};
+			static inline const table& lookup(clip<feature> range) {
+				static thread_local table t;
+				if (t.begin != range.begin() || t.end != range.end()) t = table(range);
+				return t;
+			}
+
+			constexpr static inline_always __m128i index(const board& state) {
+				__m128i x = _mm_cvtsi64_si128(u64(state)), lo = _mm_set1_epi8(0x0f);
+				return _mm_unpacklo_epi8(_mm_and_si128(x, lo), _mm_and_si128(_mm_srli_epi16(x, 4), lo)); // cell i in byte i
+			}
+			constexpr static inline_always u64 invoke(__m128i x, const typename table::control& ctrl) {
+				x = _mm_shuffle_epi8(x, _mm_load_si128(pointer_cast<__m128i>(ctrl.cell)));
+				x = _mm_maddubs_epi16(x, _mm_set1_epi16(0x1001));
+				return _mm_cvtsi128_si64(_mm_packus_epi16(x, x));
+			}
+
+			constexpr static inline numeric estimate(const board& state, clip<feature> range = feature::feats()) {
+				const table& t = lookup(range);
+				if (!t.valid) return isomorphic::estimate(state, range);
+				__m128i x = index(state);
+				numeric esti = 0;
+				for (u32 j = 0; j < 8; j++) {
+					numeric part = 0;
+					for (u32 i = 0; i < range.size(); i += 8)
+						part += range[i].at<mode>(invoke(x, t.ctrl[i + j]));
+					esti += part;
+				}
+				return esti;
+			}
+			constexpr static inline numeric optimize(const board& state, numeric updv, clip<feature> range = feature::feats()) {
+				const table& t = lookup(range);
+				if (!t.valid) return isomorphic::optimize(state, updv, range);
+				__m128i x = index(state);
+				numeric esti = 0;
+				for (u32 j = 0; j < 8; j++) {
+					numeric part = 0;
+					for (u32 i = 0; i < range.size(); i += 8)
+						part += (range[i].at<mode>(invoke(x, t.ctrl[i + j])) += updv);
+					esti += part;
+				}
+				return esti;
+			}
+		};
+#else
+		typedef isomorphic permute;
+#endif
+
+		struct prefetch { // locate and prefetch all isomorphic weights of a block of patterns, then access them
+			constexpr inline operator method() { return { prefetch::estimate, prefetch::optimize, isomorphic::locate }; }
+			static constexpr u32 block = 8;
+
+			constexpr static inline numeric estimate(const board& state, clip<feature> range = feature::feats()) {
+				numeric esti = 0;
+				numeric part[8] = {};
+				board iso[8];
+				mode* wptr[8][block];
+				isoms(state, iso);
+				for (feature* feat = range.begin(); feat != range.end(); ) {
+					u32 n = 0;
+					for (; feat != range.end() && n < block; feat += 8, n++)
+						for (u32 i = 0; i < 8; i++)
+							__builtin_prefetch(wptr[i][n] = &feat->at<mode>(iso[i]), 0);
+					for (u32 i = 0; i < 8; i++)
+						for (u32 k = 0; k < n; k++) part[i] += *wptr[i][k];
+				}
+				for (u32 i = 0; i < 8; i++) esti += part[i];
+				return esti;
+			}
+			constexpr static inline numeric optimize(const board& state, numeric updv, clip<feature> range = feature::feats()) {
+				numeric esti = 0;
+				numeric part[8] = {};
+				board iso[8];
+				mode* wptr[8][block];
+				isoms(state, iso);
+				for (feature* feat = range.begin(); feat != range.end(); ) {
+					u32 n = 0;
+					for (; feat != range.end() && n < block; feat += 8, n++)
+						for (u32 i = 0; i < 8; i++)
+							weight::prefetch<1>(wptr[i][n] = &feat->at<mode>(iso[i]));
+					for (u32 i = 0; i < 8; i++)
+						for (u32 k = 0; k < n; k++) part[i] += (*wptr[i][k] += updv);
+				}
+				for (u32 i = 0; i < 8; i++) esti += part[i];
+				return esti;
+			}
+		};
+
 		template<indexer::mapper... indexes>
 		struct static_index {
 			constexpr static std::array<indexer::mapper, sizeof...(indexes)> index = { indexes... };
-			constexpr inline operator method() { return { static_index::estimate, static_index::optimize }; }
+			constexpr inline operator method() { return { static_index::estimate, static_index::optimize, static_index::locate }; }
 
 			template<indexer::mapper index, indexer::mapper... follow> constexpr static
 			inline_always typename std::enable_if<(sizeof...(follow) != 0), numeric>::type invoke(const board& iso, clip<feature> f) {
@@ -1560,6 +2264,207 @@ struct method {
 
 			constexpr static estimator estimate = isomorphic::estimate<invoke<indexes...>>;
 			constexpr static optimizer optimize = isomorphic::optimize<invoke<indexes...>>;
+
+			constexpr static inline void locate(const board& state, clip<feature> range = feature::feats()) {
+				mode* wptr[8][sizeof...(indexes)];
+				prefetch::template locate<0>(state, wptr, range);
+			}
+
+			struct prefetch { // locate and prefetch all 8 x N weights first, then access them
+				constexpr inline operator method() { return { prefetch::estimate, prefetch::optimize, static_index::locate }; }
+
+				template<int rw, indexer::mapper index, indexer::mapper... follow> constexpr static
+				inline_always typename std::enable_if<(sizeof...(follow) != 0), void>::type locate(const board& iso, mode* wptr[], clip<feature> f) {
+					constexpr u32 i = sizeof...(indexes) - sizeof...(follow) - 1;
+					weight::prefetch<rw>(wptr[i] = &f[i << 3].at<mode>(index(iso)));
+					locate<rw, follow...>(iso, wptr, f);
+				}
+				template<int rw, indexer::mapper index, indexer::mapper... follow> constexpr static
+				inline_always typename std::enable_if<(sizeof...(follow) == 0), void>::type locate(const board& iso, mode* wptr[], clip<feature> f) {
+					constexpr u32 i = sizeof...(indexes) - sizeof...(follow) - 1;
+					weight::prefetch<rw>(wptr[i] = &f[i << 3].at<mode>(index(iso)));
+				}
+
+				template<int rw>
+				constexpr static inline_always void locate(const board& state, mode* wptr[][sizeof...(indexes)], clip<feature> f) {
+					board iso;
+					locate<rw, indexes...>(({ iso = state;     iso; }), wptr[0], f);
+					locate<rw, indexes...>(({ iso.flip();      iso; }), wptr[1], f);
+					locate<rw, indexes...>(({ iso.transpose(); iso; }), wptr[2], f);
+					locate<rw, indexes...>(({ iso.flip();      iso; }), wptr[3], f);
+					locate<rw, indexes...>(({ iso.transpose(); iso; }), wptr[4], f);
+					locate<rw, indexes...>(({ iso.flip();      iso; }), wptr[5], f);
+					locate<rw, indexes...>(({ iso.transpose(); iso; }), wptr[6], f);
+					locate<rw, indexes...>(({ iso.flip();      iso; }), wptr[7], f);
+				}
+
+				constexpr static inline numeric estimate(const board& state, clip<feature> range = feature::feats()) {
+					mode* wptr[8][sizeof...(indexes)];
+					locate<0>(state, wptr, range);
+					numeric esti = 0;
+					for (u32 i = 0; i < 8; i++) {
+						numeric part = *wptr[i][sizeof...(indexes) - 1];
+						for (u32 k = sizeof...(indexes) - 1; k-- > 0; ) part = numeric(*wptr[i][k]) + part;
+						esti += part;
+					}
+					return esti;
+				}
+				constexpr static inline numeric optimize(const board& state, numeric updv, clip<feature> range = feature::feats()) {
+					mode* wptr[8][sizeof...(indexes)];
+					locate<1>(state, wptr, range);
+					numeric esti = 0;
+					for (u32 i = 0; i < 8; i++) {
+						numeric part = (*wptr[i][sizeof...(indexes) - 1] += updv);
+						for (u32 k = sizeof...(indexes) - 1; k-- > 0; ) part = (*wptr[i][k] += updv) + part;
+						esti += part;
+					}
+					return esti;
+				}
+			};
+
+#if defined(__AVX2__) && !defined(PREFER_SCALAR_ESTIMATE)
+			struct simd { // gather the 8 isomorphic weights of a pattern at once, and reduce them with vector adds
+				constexpr inline operator method() { return { simd::estimate, simd::optimize, static_index::locate }; }
+				constexpr static u32 scale = sizeof(mode) / sizeof(numeric);
+				constexpr static optimizer optimize = static_index::optimize; // updates remain scalar
+
+				template<indexer::mapper index, indexer::mapper... follow> constexpr static
+				inline_always typename std::enable_if<(sizeof...(follow) != 0), void>::type locate(const board& iso, u64 idx[], const numeric* wght[]) {
+					constexpr u32 i = sizeof...(indexes) - sizeof...(follow) - 1;
+					__builtin_prefetch(wght[i] + (idx[i << 3] = weight::slot<mode>(index(iso)) * scale));
+					locate<follow...>(iso, idx, wght);
+				}
+				template<indexer::mapper index, indexer::mapper... follow> constexpr static
+				inline_always typename std::enable_if<(sizeof...(follow) == 0), void>::type locate(const board& iso, u64 idx[], const numeric* wght[]) {
+					constexpr u32 i = sizeof...(indexes) - sizeof...(follow) - 1;
+					__builtin_prefetch(wght[i] + (idx[i << 3] = weight::slot<mode>(index(iso)) * scale));
+				}
+
+				constexpr static inline numeric estimate(const board& state, clip<feature> range = feature::feats()) {
+					if constexpr (scale == 0) return static_index::estimate(state, range); // no gather for 16-bit storage
+					alignas(64) u64 idx[sizeof...(indexes) << 3];
+					const numeric* wght[sizeof...(indexes)];
+					for (u32 i = 0; i < sizeof...(indexes); i++)
+						wght[i] = pointer_cast<numeric>(range[i << 3].value().template data<mode>());
+					board iso;
+					locate<indexes...>(({ iso = state;     iso; }), idx + 0, wght);
+					locate<indexes...>(({ iso.flip();      iso; }), idx + 1, wght);
+					locate<indexes...>(({ iso.transpose(); iso; }), idx + 2, wght);
+					locate<indexes...>(({ iso.flip();      iso; }), idx + 3, wght);
+					locate<indexes...>(({ iso.transpose(); iso; }), idx + 4, wght);
+					locate<indexes...>(({ iso.flip();      iso; }), idx + 5, wght);
+					locate<indexes...>(({ iso.transpose(); iso; }), idx + 6, wght);
+					locate<indexes...>(({ iso.flip();      iso; }), idx + 7, wght);
+
+					__m256 esti = _mm256_setzero_ps();
+					for (u32 i = 0; i < sizeof...(indexes); i++) {
+#if defined(PREFER_LOAD_GATHER)
+						const u64* x = idx + (i << 3);
+						const numeric* w = wght[i];
+						esti = _mm256_add_ps(esti, _mm256_setr_ps(w[x[0]], w[x[1]], w[x[2]], w[x[3]], w[x[4]], w[x[5]], w[x[6]], w[x[7]]));
+#elif defined(__AVX512F__)
+						// 64-bit indexes are required by 8-tuples, all 8 isomorphisms fit in a single gather
+						__m512i x = _mm512_load_si512(idx + (i << 3));
+						esti = _mm256_add_ps(esti, _mm512_mask_i64gather_ps(_mm256_setzero_ps(), 0xff, x, wght[i], sizeof(numeric)));
+#else
+						__m256i xl = _mm256_load_si256(pointer_cast<__m256i>(idx + (i << 3) + 0));
+						__m256i xh = _mm256_load_si256(pointer_cast<__m256i>(idx + (i << 3) + 4));
+						__m128 wl = _mm256_i64gather_ps(wght[i], xl, sizeof(numeric));
+						__m128 wh = _mm256_i64gather_ps(wght[i], xh, sizeof(numeric));
+						esti = _mm256_add_ps(esti, _mm256_set_m128(wh, wl));
+#endif
+					}
+					__m128 sum = _mm_add_ps(_mm256_castps256_ps128(esti), _mm256_extractf128_ps(esti, 1));
+					sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+					sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+					return _mm_cvtss_f32(sum);
+				}
+			};
+#else
+			typedef static_index simd;
+#endif
+
+#if defined(__AVX2__) && !defined(PREFER_SCALAR_INDEX)
+			struct fused { // extract all 8 x N indexes from the unpacked board with pshufb, no isomorphic transform is needed
+				constexpr inline operator method() { return { fused::estimate, fused::optimize, fused::locate }; }
+				constexpr static u32 N = sizeof...(indexes);
+				constexpr static u32 R = (N * 8 + 3) / 4; // each register holds 4 indexes
+
+				struct control {
+					alignas(32) u8 ctrl[R][32];
+					control() { // probe the cells of each pattern, then map them through the isomorphisms
+						board iso = 0xfedcba9876543210ull, cell[8];
+						for (u32 j = 0; j < 8; j++) { // same chain as isomorphic::estimate: flip, transpose, flip, ...
+							cell[j] = iso;
+							if (j & 1) iso.transpose(); else iso.flip();
+						}
+						std::fill_n(&ctrl[0][0], R * 32, 0x80);
+						for (u32 j = 0; j < 8; j++) {
+							for (u32 i = 0; i < N; i++) {
+								u8* x = &ctrl[(j * N + i) / 4][((j * N + i) % 4) * 8];
+								for (u32 c = 0; c < 16; c++) {
+									u64 t = index[i](board(1ull << (c << 2)));
+									if (t) x[math::tzcnt64(t) >> 2] = cell[j].at(c);
+								}
+							}
+						}
+					}
+				};
+				inline static const control ctl;
+
+				constexpr static inline_always void extract(const board& state, u64 idx[]) {
+					__m128i x = _mm_cvtsi64_si128(u64(state)), lo = _mm_set1_epi8(0x0f);
+					x = _mm_unpacklo_epi8(_mm_and_si128(x, lo), _mm_and_si128(_mm_srli_epi16(x, 4), lo)); // cell i in byte i
+					__m256i b = _mm256_broadcastsi128_si256(x);
+					for (u32 r = 0; r < R; r++) {
+						__m256i v = _mm256_shuffle_epi8(b, _mm256_load_si256(pointer_cast<__m256i>(ctl.ctrl[r])));
+						v = _mm256_maddubs_epi16(v, _mm256_set1_epi16(0x1001)); // 2 cells in a 16-bit lane
+						v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x01000001)); // 4 cells in a 32-bit lane
+						v = _mm256_or_si256(v, _mm256_srli_epi64(v, 16)); // 8 cells in a 64-bit lane
+						v = _mm256_and_si256(v, _mm256_set1_epi64x(0xffffffffull));
+						_mm256_store_si256(pointer_cast<__m256i>(idx + (r << 2)), v);
+					}
+				}
+				template<int rw>
+				constexpr static inline_always void locate(const board& state, mode* wptr[][N], clip<feature> f) {
+					alignas(32) u64 idx[R << 2];
+					extract(state, idx);
+					for (u32 j = 0; j < 8; j++)
+						for (u32 i = 0; i < N; i++)
+							weight::prefetch<rw>(wptr[j][i] = &f[i << 3].at<mode>(idx[j * N + i]));
+				}
+
+				constexpr static inline void locate(const board& state, clip<feature> range = feature::feats()) {
+					mode* wptr[8][N];
+					locate<0>(state, wptr, range);
+				}
+				constexpr static inline numeric estimate(const board& state, clip<feature> range = feature::feats()) {
+					mode* wptr[8][N];
+					locate<0>(state, wptr, range);
+					numeric esti = 0;
+					for (u32 j = 0; j < 8; j++) {
+						numeric part = *wptr[j][N - 1];
+						for (u32 i = N - 1; i-- > 0; ) part = numeric(*wptr[j][i]) + part;
+						esti += part;
+					}
+					return esti;
+				}
+				constexpr static inline numeric optimize(const board& state, numeric updv, clip<feature> range = feature::feats()) {
+					mode* wptr[8][N];
+					locate<1>(state, wptr, range);
+					numeric esti = 0;
+					for (u32 j = 0; j < 8; j++) {
+						numeric part = (*wptr[j][N - 1] += updv);
+						for (u32 i = N - 1; i-- > 0; ) part = (*wptr[j][i] += updv) + part;
+						esti += part;
+					}
+					return esti;
+				}
+			};
+#else
+			typedef prefetch fused;
+#endif
+			typedef fused permute; // fused already indexes the isomorphisms by permutations
 		};
 
 		typedef typename isomorphic<mode>::template static_index<
@@ -1609,11 +2514,14 @@ struct method {
 		typedef typename isomorphic<mode>::template static_index<
 				index::indexpt<0x0,0x1,0x2,0x3,0x4,0x5,0x6,0x7>,
 				index::indexpt<0x4,0x5,0x6,0x7,0x8,0x9,0xa,0xb>> idx2x8patt;
+#if defined(NETWORK_INDEX)
+		typedef typename isomorphic<mode>::template static_index<NETWORK_INDEX> idxnetwork; // make NETWORK="..."
+#endif
 	};
 
 	template<typename source = common<weight::segment>>
 	struct expectimax {
-		constexpr inline operator method() { return { expectimax<source>::estimate, expectimax<source>::optimize }; }
+		constexpr inline operator method() { return { expectimax<source>::estimate, expectimax<source>::optimize, expectimax<source>::locate }; }
 		constexpr inline expectimax(utils::options::option opt) {
 			std::stringstream input;
 			auto next = [&](u32 n) -> u32 {
@@ -1642,17 +2550,26 @@ struct method {
 			cache::block::access lookup = cache::find(after, depth);
 			if (lookup) return lookup.fetch();
 			if (!depth) return source::estimate(after, range);
-			for (u64 slot; (slot = *slots) != 0; slots++) {
-				expt += 0.9 * search_best(u64(after) | (slot << 0), depth - 1, range);
-				expt += 0.1 * search_best(u64(after) | (slot << 1), depth - 1, range);
+			board before[32], moves[128];
+			for (u32 i = 0; i < empty; i++, slots++) {
+				before[(i << 1) + 0] = u64(after) | (*slots << 0);
+				before[(i << 1) + 1] = u64(after) | (*slots << 1);
+			}
+			board::moves_batch(before, moves, empty << 1);
+			for (u32 i = 0; i < empty; i++) {
+				expt += 0.9 * search_best(moves + (i << 3) + 0, depth - 1, range);
+				expt += 0.1 * search_best(moves + (i << 3) + 4, depth - 1, range);
 			}
 			expt = lookup.store(expt / empty);
 			return expt;
 		}
 
 		static inline numeric search_best(const board& before, u32 depth, clip<feature> range = feature::feats()) {
+			return search_best(before.moves<board>().data(), depth, range);
+		}
+		static inline numeric search_best(const board moves[], u32 depth, clip<feature> range = feature::feats()) {
 			numeric best = 0, expt, esti;
-			for (const board& after : before.moves<board>()) {
+			for (const board& after : clip<const board>(moves, moves + 4)) {
 				if (after.info() == -1u) continue;
 				expt = search_expt(after, depth - 1, range);
 				esti = after.info() + std::max(expt, numeric(0));
@@ -1667,6 +2584,9 @@ struct method {
 		static inline numeric optimize(const board& state, numeric updv, clip<feature> range = feature::feats()) {
 			return source::optimize(state, updv, range);
 		}
+		static inline void locate(const board& after, clip<feature> range = feature::feats()) {
+			// nothing to prefetch, the weights are only accessed at the leaves of the search
+		}
 
 		static inline u32& depth() { static u32 depth = 1; return depth; }
 		static inline u32& depth(u32 n) { return (expectimax<source>::depth() = n); }
@@ -1680,9 +2600,27 @@ struct method {
 		return spec();
 	}
 
+	template<typename spec>
+	static method variant(std::string kern, utils::options::option opt) {
+		switch (to_hash(kern)) {
+		default: return option<spec>(opt);
+		case to_hash("prefetch"): return option<typename spec::prefetch>(opt);
+		case to_hash("simd"): return option<typename spec::simd>(opt);
+		case to_hash("fused"): return option<typename spec::fused>(opt);
+		case to_hash("permute"): return option<typename spec::permute>(opt);
+		}
+	}
+
 	template<typename mode = weight::segment>
 	static method specialize(utils::options::option opt) {
-		std::string spec = opt["spec"].value("auto");
+		std::string spec = opt["spec"].value("auto"), kern = "default";
+		if (spec.find(':') != std::string::npos) { // e.g., spec=8x6patt:prefetch
+			kern = spec.substr(spec.find(':') + 1);
+			spec = spec.substr(0, spec.find(':'));
+		} else if (spec == "prefetch" || spec == "simd" || spec == "fused" || spec == "permute") {
+			kern = spec;
+			spec = "auto";
+		}
 		if (spec == "auto") {
 			u32 m = weight::wghts().size();
 			u32 n = m ? math::log2(weight::wghts().front().size()) >> 2 : 0;
@@ -1692,16 +2630,22 @@ struct method {
 					[=](u32 n, feature f) { return n + (f.value() == w ? 1 : 0); }) != 8) m = 0;
 				if (w.sign().find_first_not_of("0123456789abcdef") != std::string::npos) n = 0;
 				if (math::log2(w.size()) >> 2 != n) n = 0;
+				if (n && w.size() != 1ull << (n << 2)) n = 0; // capped alphabet
 			}
 			if (m) { // if features are assumed as isomorphic
 				std::string list = "4x6patt 5x6patt 6x6patt 7x6patt 8x6patt 2x7patt 3x7patt 1x8patt 2x8patt ";
 				std::string make = opt["make"].value("?"), patt = make.substr(0, make.find_first_of("@&|="));
 				std::string form = format("%ux%upatt", m, n);
+				std::string sign = std::accumulate(weight::wghts().begin(), weight::wghts().end(), std::string{},
+						[](std::string s, weight w) { return s + w.sign() + ' '; });
+#if defined(NETWORK_INDEX)
+				if (n && sign == NETWORK_SIGN " ") {
+					spec = "network";
+				} else
+#endif
 				if (list.find(patt) != std::string::npos && make.find(' ') == std::string::npos) {
 					spec = patt;
-				} else if (list.find(form) != std::string::npos &&
-					std::accumulate(weight::wghts().begin(), weight::wghts().end(), std::string{},
-						[](std::string s, weight w) { return s + w.sign() + ' '; }) == utils::resolve(form)) {
+				} else if (list.find(form) != std::string::npos && sign == utils::resolve(form)) {
 					spec = form;
 				} else {
 					spec = "isomorphic";
@@ -1711,17 +2655,20 @@ struct method {
 			}
 		}
 		switch (to_hash(spec)) {
-		default: return option<common<mode>>(opt);
-		case to_hash("isomorphic"): return option<isomorphic<mode>>(opt);
-		case to_hash("4x6patt"): return option<typename isomorphic<mode>::idx4x6patt>(opt);
-		case to_hash("5x6patt"): return option<typename isomorphic<mode>::idx5x6patt>(opt);
-		case to_hash("6x6patt"): return option<typename isomorphic<mode>::idx6x6patt>(opt);
-		case to_hash("7x6patt"): return option<typename isomorphic<mode>::idx7x6patt>(opt);
-		case to_hash("8x6patt"): return option<typename isomorphic<mode>::idx8x6patt>(opt);
-		case to_hash("2x7patt"): return option<typename isomorphic<mode>::idx2x7patt>(opt);
-		case to_hash("3x7patt"): return option<typename isomorphic<mode>::idx3x7patt>(opt);
-		case to_hash("1x8patt"): return option<typename isomorphic<mode>::idx1x8patt>(opt);
-		case to_hash("2x8patt"): return option<typename isomorphic<mode>::idx2x8patt>(opt);
+		default: return variant<common<mode>>(kern, opt);
+		case to_hash("isomorphic"): return variant<isomorphic<mode>>(kern, opt);
+		case to_hash("4x6patt"): return variant<typename isomorphic<mode>::idx4x6patt>(kern, opt);
+		case to_hash("5x6patt"): return variant<typename isomorphic<mode>::idx5x6patt>(kern, opt);
+		case to_hash("6x6patt"): return variant<typename isomorphic<mode>::idx6x6patt>(kern, opt);
+		case to_hash("7x6patt"): return variant<typename isomorphic<mode>::idx7x6patt>(kern, opt);
+		case to_hash("8x6patt"): return variant<typename isomorphic<mode>::idx8x6patt>(kern, opt);
+		case to_hash("2x7patt"): return variant<typename isomorphic<mode>::idx2x7patt>(kern, opt);
+		case to_hash("3x7patt"): return variant<typename isomorphic<mode>::idx3x7patt>(kern, opt);
+		case to_hash("1x8patt"): return variant<typename isomorphic<mode>::idx1x8patt>(kern, opt);
+		case to_hash("2x8patt"): return variant<typename isomorphic<mode>::idx2x8patt>(kern, opt);
+#if defined(NETWORK_INDEX)
+		case to_hash("network"): return variant<typename isomorphic<mode>::idxnetwork>(kern, opt);
+#endif
 		}
 	}
 
@@ -1730,6 +2677,9 @@ struct method {
 		default:
 		case weight::structure::code: return method::specialize<weight::structure>(opt);
 		case weight::coherence::code: return method::specialize<weight::coherence>(opt);
+		case weight::float16::code: return method::specialize<weight::float16>(opt);
+		case weight::bfloat16::code: return method::specialize<weight::bfloat16>(opt);
+		case weight::quantized::code: return method::specialize<weight::quantized>(opt);
 		}
 	}
 
@@ -1788,6 +2738,23 @@ struct select {
 		best = std::max_element(move, move + 4);
 		return *this;
 	}
+	inline select& operator ()(clip<feature> range = feature::feats(), method::estimator estim = method::estimate) {
+		move[0].evaluate(range, estim);
+		move[1].evaluate(range, estim);
+		move[2].evaluate(range, estim);
+		move[3].evaluate(range, estim);
+		best = std::max_element(move, move + 4);
+		return *this;
+	}
+	inline select& prefetch(const board& b, // expand b and prefetch the weights, then evaluate with operator ()(range, estim)
+			clip<feature> range = feature::feats(), method::locator fetch = method::locate) {
+		b.moves(move[0], move[1], move[2], move[3]);
+		if (move[0]) fetch(move[0], range);
+		if (move[1]) fetch(move[1], range);
+		if (move[2]) fetch(move[2], range);
+		if (move[3]) fetch(move[3], range);
+		return *this;
+	}
 	inline select& operator <<(const board& b) { return operator ()(b); }
 	inline const select& operator >>(std::vector<state>& path) const { path.push_back(*best); return *this; }
 	inline const select& operator >>(state& s) const { s = *best; return *this; }
@@ -1814,6 +2781,7 @@ struct statistic {
 		u32 win;
 		u32 thdid;
 		u32 thdnum;
+		u32 save;
 	} info;
 
 	struct record {
@@ -1849,7 +2817,8 @@ struct statistic {
 	statistic() : info{}, total{}, local{}, accum{} {}
 	statistic(const statistic&) = default;
 
-	bool init(utils::options::option opt = {}) {
+	static execinfo parse(utils::options::option opt) {
+		execinfo info = {};
 		std::string conf = opt.value().substr(0, opt.value().find(' ')) + "x:";
 		info.loop = opt["loop"].value((opt["-"] = conf).value(1000));
 		info.unit = opt["unit"].value((opt["-"] = conf.substr(conf.find('x') + 1)).value(1000));
@@ -1857,18 +2826,78 @@ struct statistic {
 
 		info.thdid  = opt["thread#"].value(0);
 		info.thdnum = opt["thread"].value(1);
-		info.loop  = info.loop / info.thdnum + (info.loop % info.thdnum && info.thdid < (info.loop % info.thdnum) ? 1 : 0);
-		info.limit = info.loop * info.unit;
+		return info;
+	}
+
+	bool init(utils::options::option opt = {}) {
+		info = parse(opt);
+		if (!sched()) { // split the episodes statically, otherwise they are claimed on demand
+			info.loop  = info.loop / info.thdnum + (info.loop % info.thdnum && info.thdid < (info.loop % info.thdnum) ? 1 : 0);
+			info.limit = info.loop * info.unit;
+		} else {
+			info.loop  = 0;
+			info.limit = 0;
+		}
+		info.save = info.thdid == 0 && std::string(opt["mode"]).find("optimize") == 0; // only the first thread takes checkpoints
 		format(0, (info.thdnum > 1) ? (" [" + std::to_string(info.thdid) + "]") : "");
 
 		total = {};
 		local = {};
 		accum = {};
-		for (u32 i = 0; i < info.thdid; i++) moporgic::srand(moporgic::rand());
+		moporgic::random::jump(info.thdid);
 		local.time = moporgic::millisec();
 		info.loop = 1;
 
-		return info.limit;
+		return sched() ? sched()->limit : info.limit;
+	}
+
+	/**
+	 * the progress shared by threads under dynamic scheduling, in which each thread claims episodes one by one
+	 * results are gathered into the records of global units, and the thread that finishes a unit reports it
+	 */
+	struct tally {
+		std::atomic<u64> score, opers, win, count, time;
+		std::atomic<u32> scale, max;
+		inline u64 update(u32 score, u32 scale, u32 opers, u32 win) {
+			this->score += score;
+			this->opers += opers;
+			this->win += win;
+			this->scale |= scale;
+			for (u32 max = this->max; max < score && !this->max.compare_exchange_weak(max, score); );
+			return ++this->count;
+		}
+		inline operator record() const { return { score, opers, time, win, scale, max }; }
+	};
+	struct schedule {
+		std::atomic<u64> claim, done, save;
+		u64 limit, unit, start;
+		tally total, *units;
+	};
+	static inline schedule*& sched() { static schedule* sched = nullptr; return sched; }
+
+	static void share(utils::options::option opt) { // allocate in SHM if workers are forked
+		execinfo info = parse(opt);
+		schedule* s = shm::enable() ? shm::alloc<schedule>(1) : new schedule();
+		s->units = shm::enable() ? shm::alloc<tally>(info.loop) : new tally[info.loop]();
+		s->limit = info.loop * info.unit;
+		s->unit = info.unit;
+		s->start = moporgic::millisec();
+		sched() = s;
+	}
+	static void unshare() {
+		schedule* s = std::exchange(sched(), nullptr);
+		if (!s) return;
+		shm::enable() ? shm::free(s->units) : delete[] s->units;
+		shm::enable() ? shm::free(s) : delete s;
+	}
+	inline bool claim() { // claim one more episode for this thread
+		if (!sched() || sched()->claim++ >= sched()->limit) return false;
+		info.limit++;
+		return true;
+	}
+	inline u64 reserve(u64 num) { // claim episodes to be launched at first, e.g., for interleaved games
+		while (info.limit < num && claim());
+		return std::min(num, info.limit);
 	}
 
 	struct string : std::array<char, 64> {
@@ -1877,7 +2906,7 @@ struct statistic {
 	} indexf, localf, totalf, summaf;
 
 	void format(u32 dec = 0, const std::string& suffix = "") {
-		if (!dec) dec = std::max(std::floor(std::log10(info.limit / info.unit)) + 1, 3.0);
+		if (!dec) dec = std::max(std::floor(std::log10((sched() ? sched()->limit : info.limit) / info.unit)) + 1, 3.0);
 		indexf = "%0" + std::to_string(dec) + PRIu64 "/%0" + std::to_string(dec) + PRIu64 " %" PRIu64 "ms %.2fops" + suffix;
 		localf = "local: " + std::string(dec * 2 - 5, ' ') + "avg=%" PRIu64 " max=%u tile=%u win=%.2f%%";
 		totalf = "total: " + std::string(dec * 2 - 5, ' ') + "avg=%" PRIu64 " max=%u tile=%u win=%.2f%%";
@@ -1886,7 +2915,7 @@ struct statistic {
 
 	inline void operator++(int) { ++info.loop; }
 	inline void operator++() { ++info.loop; }
-	inline operator bool() const { return info.loop <= info.limit; }
+	inline operator bool() { return info.loop <= info.limit || claim(); }
 	inline bool checked() const { return (info.loop % info.unit) == 0; }
 
 	struct stat { u32 score, scale, opers; };
@@ -1902,40 +2931,68 @@ struct statistic {
 		accum.score[math::log2(scale)] += score;
 		accum.opers[math::log2(scale)] += opers;
 
+		if (sched()) return gather(score, scale, opers);
 		if ((info.loop % info.unit) != 0) return;
 
 		u64 tick = moporgic::millisec();
 		local.time = tick - local.time;
 		total += local;
 
+		report(info.loop / info.unit, info.limit / info.unit, local, info.unit, total, info.loop);
+
+		local = {};
+		local.time = tick;
+		if (info.save) utils::checkpoint::save(info.loop / info.unit);
+	}
+
+	void gather(u32 score, u32 scale, u32 opers) { // fold the episode into the total, and into its global unit
+		u64 tick = moporgic::millisec();
+		local.time = tick - local.time;
+		total += local;
+		schedule& s = *sched();
+		u64 i = s.done++, u = i / s.unit;
+		tally& unit = s.units[u];
+		s.total.update(score, scale, opers, local.win);
+		u64 count = unit.update(score, scale, opers, local.win);
+		local = {};
+		local.time = tick;
+		if (count == s.unit) {
+			u64 last = u ? s.units[u - 1].time.load() : s.start;
+			for (; !last; last = s.units[u - 1].time) std::this_thread::yield(); // publish the end times of units in order
+			record rec = unit;
+			rec.time = (unit.time = std::max(tick, last)) - last;
+			report(u + 1, s.limit / s.unit, rec, s.unit, s.total, s.total.count);
+			if (utils::checkpoint::due(u + 1)) s.save = u + 1; // leave the checkpoint to the first thread
+		}
+		if (u64 due = info.save ? s.save.exchange(0) : 0) utils::checkpoint::save(due);
+	}
+
+	void report(u64 index, u64 count, const record& local, u64 unit, const record& total, u64 loop) const {
 		char buf[256];
 		u32 size = 0;
 
 		size += snprintf(buf + size, sizeof(buf) - size, indexf, // "%03llu/%03llu %llums %.2fops",
-				info.loop / info.unit,
-				info.limit / info.unit,
+				index,
+				count,
 				local.time,
 				local.opers * 1000.0 / local.time);
 		buf[size++] = '\n';
 		size += snprintf(buf + size, sizeof(buf) - size, localf, // "local:  avg=%llu max=%u tile=%u win=%.2f%%",
-				local.score / info.unit,
+				local.score / unit,
 				local.max,
 				math::msb32(local.scale),
-				local.win * 100.0 / info.unit);
+				local.win * 100.0 / unit);
 		buf[size++] = '\n';
 		size += snprintf(buf + size, sizeof(buf) - size, totalf, // "total:  avg=%llu max=%u tile=%u win=%.2f%%",
-				total.score / info.loop,
+				total.score / loop,
 				total.max,
 				math::msb32(total.scale),
-				total.win * 100.0 / info.loop);
+				total.win * 100.0 / loop);
 		buf[size++] = '\n';
 		buf[size++] = '\n';
 		buf[size++] = '\0';
 
 		std::cout << buf << std::flush;
-
-		local = {};
-		local.time = tick;
 	}
 
 	void summary() const {
@@ -2035,6 +3092,39 @@ statistic run(utils::options::option opt) {
 		}
 		}(); break;
 
+	case to_hash("optimize:interleave"): [&]() {
+		struct game { state b, a; select best; u32 score, opers; };
+		stats.init(opt);
+		std::vector<game> games(stats.reserve(opt["K"].value(2)));
+		u64 launch = games.size();
+		for (game& g : games) g.b.init();
+
+		while (games.size()) {
+			for (game& g : games) g.best.prefetch(g.b, feats, spec.fetch);
+			for (u32 i = 0; i < games.size(); ) {
+				game& g = games[i];
+				if (g.best(feats, spec)) {
+					if (g.opers) g.a.optimize(g.best.esti(), alpha, feats, spec);
+					g.score += g.best.score();
+					g.opers += 1;
+					g.best >> g.a >> g.b;
+					g.b.next();
+					i++;
+					continue;
+				}
+				g.a.optimize(0, alpha, feats, spec);
+
+				stats.update(g.score, g.b.scale(), g.opers);
+				stats++;
+				if (launch < stats.info.limit || stats.claim()) {
+					g = {}, g.b.init(), launch++, i++;
+				} else {
+					g = games.back(), games.pop_back();
+				}
+			}
+		}
+		}(); break;
+
 	case to_hash("optimize:forward"): [&]() {
 		for (stats.init(opt); stats; stats++) {
 			state b, a;
@@ -2390,6 +3480,37 @@ statistic run(utils::options::option opt) {
 		}
 		}(); break;
 
+	case to_hash("evaluate:interleave"): [&]() {
+		struct game { board b; select best; u32 score, opers; };
+		stats.init(opt);
+		std::vector<game> games(stats.reserve(opt["K"].value(2)));
+		u64 launch = games.size();
+		for (game& g : games) g.b.init();
+
+		while (games.size()) {
+			for (game& g : games) g.best.prefetch(g.b, feats, spec.fetch);
+			for (u32 i = 0; i < games.size(); ) {
+				game& g = games[i];
+				if (g.best(feats, spec)) {
+					g.score += g.best.score();
+					g.opers += 1;
+					g.best >> g.b;
+					g.b.next();
+					i++;
+					continue;
+				}
+
+				stats.update(g.score, g.b.scale(), g.opers);
+				stats++;
+				if (launch < stats.info.limit || stats.claim()) {
+					g = {}, g.b.init(), launch++, i++;
+				} else {
+					g = games.back(), games.pop_back();
+				}
+			}
+		}
+		}(); break;
+
 	case to_hash("evaluate:stage"):
 	case to_hash("evaluate:shift"): [&]() {
 		u32 shift = opt["shift"].value(65536);
@@ -2575,6 +3696,15 @@ utils::options parse(int argc, const char* argv[]) {
 
 	if (!opts("recipes")) opts["recipes"] = "optimize", opts["optimize"] = 1000;
 	if (!opts("seed")) opts["seed"] = format("%08" PRIx32, math::fmix32(microsec()));
+	if (opts("options", "quantize") || opts("alpha", "quantize")) { // quantized weights are never updated, so training would be a no-op
+		auto train = [](std::string recipe) { return recipe.find("optimize") == 0; };
+		auto quantize = std::bind(utils::options::opinion::comp, std::placeholders::_1, "quantize");
+		if (std::any_of(opts["recipes"].begin(), opts["recipes"].end(), train)) {
+			std::cerr << "warning: quantize is ignored since the network is being trained" << std::endl;
+			opts["options"].remove_if(quantize);
+			opts["alpha"].remove_if(quantize);
+		}
+	}
 
 	for (std::string recipe : opts["recipes"]) {
 		std::string form = recipe.substr(0, recipe.find('#'));
@@ -2624,9 +3754,11 @@ utils::options parse(int argc, const char* argv[]) {
 }
 
 int main(int argc, const char* argv[]) {
+	f64 startup = std::clock() * 1000.0 / CLOCKS_PER_SEC; // including the loader and static initialization
 	utils::options opts = parse(argc, argv);
 	utils::handle_routine(opts["run"]);
 	utils::init_logging(opts["save"]);
+	utils::checkpoint::config(opts["save"], opts["options"]);
 
 	std::cout << "TDL2048+ by Hung Guei" << std::endl;
 	std::cout << "Develop" << format(" Rev.%s (GCC %s C++%d @ %s %s)",
@@ -2640,24 +3772,28 @@ int main(int argc, const char* argv[]) {
 	std::cout << "stage = " << "{" << opts["stage"].value("0") << "}, block = " << opts["block"].value(65536) << std::endl;
 	std::cout << "search = " << opts["search"].value("1p") << ", cache = " << opts["cache"].value("none") << std::endl;
 	std::cout << "thread = " << opts["thread"].value(1) << "x" << std::endl;
+	std::cout << "startup = " << format("%.2fms", startup) << std::endl;
 	std::cout << std::endl;
 
 	utils::config_random(opts["seed"]);
-	utils::config_memory(opts["thread"]);
-	utils::config_weight(opts["alpha"]);
+	utils::config_memory(opts["thread"], opts["options"]);
+	utils::config_weight(opts["alpha"], opts["options"]);
 
 	utils::init_cache(opts["cache"]);
-	utils::load_network(opts["load"]);
+	utils::load_network(opts["load"], opts["options"]);
 	utils::make_network(opts["make"]);
 	utils::list_network();
+	if (page::enable()) std::cout << "alloc = " << page::report() << std::endl << std::endl;
 
 	for (std::string recipe : opts["recipes"]) {
 		std::cout << opts[recipe]["what"] << std::endl << std::endl;
 		statistic stat = utils::invoke(run, opts[recipe]);
 		if (opts[recipe]("info")) stat.summary();
 	}
+	if (weight::sparse() && opts["recipes"].size()) utils::list_network(); // usage of sparse tables after the recipes
 
-	utils::save_network(opts["save"]);
+	utils::checkpoint::wait();
+	utils::save_network(opts["save"], opts["options"]);
 
 	return 0;
 }
@@ -55,19 +55,21 @@ public:
 	class cache {
 	public:
 		static inline const cache& load(u32 i) {
-			static byte block[sizeof(cache) * (1 << 20)] = {};
-			return pointer_cast<cache>(block)[i];
+			static const cache* block = make(); // the metadata are built on the first query
+			return block[i];
 		}
-		static __attribute__((constructor)) void make() {
-			for (u32 i = 0; i < (1 << 20); i++) new (const_cast<cache*>(&load(i))) cache(i);
+		static const cache* make() {
+			static byte block[sizeof(cache) * (1 << 20)] = {};
+			for (u32 i = 0; i < (1 << 20); i++) new (pointer_cast<cache>(block) + i) cache(i);
+			return pointer_cast<cache>(block);
 		}
 
 	public:
 		cache(const cache& c) = default;
 		cache(u32 src) : raw(src & 0xffffu), ext(src >> 16) {
-			std::array<u32, 4> row;
+			std::array<u32, 4> row = unpack(src);
 			for (u32 i = 0; i < 4; i++) {
-				u32 t = row[i] = ((src >> (i << 2)) & 0x0f) | ((src >> (i + 12)) & 0x10);
+				u32 t = row[i];
 				species |= (1 << t);
 				numof[t] += 1;
 			}
@@ -76,108 +78,136 @@ public:
 				u32 t0 = row[cmp[i][0]], t1 = row[cmp[i][1]];
 				mono |= ((t0 | t1) ? ((t0 >= t1) | ((t1 >= t0) << 1)) : 0) << (i << 1);
 			}
-			auto res_l = slide(row, src, +1);
-			auto res_r = slide(row, src, -1);
-			mvl = std::get<0>(res_l);
-			mvr = std::get<0>(res_r);
-			score = std::get<1>(res_l);
-			merge = std::get<2>(res_l);
-			moved = (mvl.moved | mvr.moved);
-			legal = (mvl.moved & 0b1001) | (mvr.moved & 0b0110);
+			u32 ignore = 0, mvl = move::slide(src, 0, +1, score), mvr = move::slide(src, 3, -1, ignore);
+			for (u32 t : unpack(mvl)) merge += (t != 0) ? 0 : 1;
+			merge -= numof[0]; // the number of tiles decreases by one for each merge
+			moved = (mvl != src || mvr != src) ? -1 : 0;
+			legal = (mvl != src ? 0b1001 : 0) | (mvr != src ? 0b0110 : 0);
 		}
 
-		class move {
+		class move { // compact move records for the LUT-based move kernels
 		public:
-			move() : rawh(), exth(), moved(), extv(), rawv() {}
-			move(const std::array<u32, 4>& row, u32 src) {
-				u32 lo[] = { (row[0] & 0x0f),      (row[1] & 0x0f),      (row[2] & 0x0f),      (row[3] & 0x0f) };
-				u32 hi[] = { (row[0] & 0x10) >> 4, (row[1] & 0x10) >> 4, (row[2] & 0x10) >> 4, (row[3] & 0x10) >> 4 };
-				rawh  = (     (lo[0]  <<  0)  | (    lo[1]  <<  4)  | (    lo[2]  <<  8)  | (    lo[3]  << 12) );
-				exth  = (     (hi[0]  <<  0)  | (    hi[1]  <<  1)  | (    hi[2]  <<  2)  | (    hi[3]  <<  3) );
-				rawv  = ( (u64(lo[0]) <<  0)  | (u64(lo[1]) << 16)  | (u64(lo[2]) << 32)  | (u64(lo[3]) << 48) );
-				extv  = (     (hi[0]  <<  0)  | (    hi[1]  <<  4)  | (    hi[2]  <<  8)  | (    hi[3]  << 12) );
-				moved = ( (u32(rawh) | (u32(exth) << 16)) != src) ? -1 : 0;
-			}
-			template<int i> inline void moveh64(board& mv) const {
-				mv.raw |= u64(rawh) << (i << 4);
-			}
-			template<int i> inline void moveh80(board& mv) const {
-				mv.raw |= u64(rawh) << (i << 4);
-				mv.ext |= u16(exth) << (i << 2);
+			static inline const move& load(u32 i) {
+				static const move* block = make(); // 20-bit rows are built on the first query
+				return block[i];
 			}
-			template<int i> inline void movev64(board& mv) const {
-				mv.raw |= u64(rawv) << (i << 2);
-			}
-			template<int i> inline void movev80(board& mv) const {
-				mv.raw |= u64(rawv) << (i << 2);
-				mv.ext |= u16(extv) << (i);
+#if !defined(PREFER_RUNTIME_LUT)
+			static inline const move& load16(u32 i); // 16-bit rows are generated at compile time
+#else
+			static inline const move& load16(u32 i) { return load(i); }
+#endif
+			static const move* make() {
+				static move block[1 << 20];
+				for (u32 i = 0; i < (1 << 20); i++) block[i] = move(i);
+				return block;
 			}
+
 		public:
-			u16 rawh;  // horizontal move (16-bit raw)
-			u8  exth;  // horizontal move (4-bit extra)
-			i8  moved; // moved (-1) or not (0)
-			u16 extv;  // vertical move (16-bit extra)
-			u64 rawv;  // vertical move (64-bit raw)
-		};
+			constexpr move() : rawl(), rawr(), score(), extx() {}
+			constexpr move(const move& m) = default;
+			constexpr move& operator =(const move& m) = default;
+			constexpr move(u32 src) : move() {
+				u32 reward = 0, ignore = 0, mvl = slide(src, 0, +1, reward), mvr = slide(src, 3, -1, ignore);
+				rawl = mvl;
+				rawr = mvr;
+				score = reward;
+				extx = (mvl >> 16) | ((mvr >> 16) << 4);
+			}
 
-	protected:
-		std::tuple<move, u32, u32> slide(std::array<u32, 4> row, u32 src, int step = 1) const {
-			u32 score = 0, merge = 0;
-			u32 idx[4] = {0, 1, 2, 3};
-			if (step == -1) std::reverse(idx, idx + 4);
-			u32 top = idx[0], hold = 0;
-			for (u32 i : idx) {
-				u32 tile = row[i];
-				if (tile == 0) continue;
-				row[i] = 0;
-				if (hold) {
+			constexpr static u32 slide(u32 src, int top, int step, u32& score) { // lightweight slide for compile-time tables
+				u32 dst = 0, hold = 0;
+				for (int i = top; i >= 0 && i < 4; i += step) {
+					u32 tile = ((src >> (i << 2)) & 0x0f) | ((src >> (i + 12)) & 0x10);
+					if (tile == 0) continue;
 					if (tile == hold) {
-						hold = ++tile;
-						score += (1 << tile);
-						merge++;
-						tile = 0;
+						score += (1 << ++tile);
+						hold = 0;
+					} else {
+						std::swap(tile, hold);
+						if (tile == 0) continue;
 					}
-					row[top] = hold;
+					dst |= ((tile & 0x0f) << (top << 2)) | ((tile & 0x10) << (top + 12));
 					top += step;
 				}
-				hold = tile;
+				dst |= ((hold & 0x0f) << (top << 2)) | ((hold & 0x10) << (top + 12));
+				return dst;
 			}
-			row[top] = hold;
-			return {move(row, src), score, merge};
-		}
 
-	public:
-		template<u32 op, u32 i> inline void move64(board& mv) const {
-			switch (op) {
-			case action::up:    mvl.movev64<i>(mv); mv.inf += score; break;
-			case action::right: mvr.moveh64<i>(mv); mv.inf += score; break;
-			case action::down:  mvr.movev64<i>(mv); mv.inf += score; break;
-			case action::left:  mvl.moveh64<i>(mv); mv.inf += score; break;
+			constexpr static inline u64 spread(u32 h) { // 0x4321 -> 0x0004000300020001
+#if defined(__BMI2__) && !defined(PREFER_LEGACY_SPREAD)
+				return math::pdep64(h, 0x000f000f000f000full);
+#else
+				u64 x = ((h | (u64(h) << 24)) & 0x000000ff000000ffull);
+				return ((x | (x << 12)) & 0x000f000f000f000full);
+#endif
 			}
-		}
-		template<u32 op, u32 i> inline void move80(board& mv) const {
-			switch (op) {
-			case action::up:    mvl.movev80<i>(mv); mv.inf += score; break;
-			case action::right: mvr.moveh80<i>(mv); mv.inf += score; break;
-			case action::down:  mvr.movev80<i>(mv); mv.inf += score; break;
-			case action::left:  mvl.moveh80<i>(mv); mv.inf += score; break;
+			constexpr static inline u32 spreadx(u32 e) { // 0b1111 -> 0x1111
+				return (e | (e << 3) | (e << 6) | (e << 9)) & 0x1111;
 			}
-		}
-		template<int i> inline void moveh64(board& L, board& R) const {
-			move64<action::left,  i>(L);
-			move64<action::right, i>(R);
-		}
-		template<int i> inline void moveh80(board& L, board& R) const {
-			move80<action::left,  i>(L);
-			move80<action::right, i>(R);
-		}
-		template<int i> inline void movev64(board& U, board& D) const {
-			move64<action::up,   i>(U);
-			move64<action::down, i>(D);
-		}
-		template<int i> inline void movev80(board& U, board& D) const {
-			move80<action::up,   i>(U);
-			move80<action::down, i>(D);
+
+			template<u32 op, u32 i> inline void move64(board& mv) const {
+				switch (op) {
+				case action::up:    mv.raw |= spread(rawl) << (i << 2); mv.inf += score; break;
+				case action::right: mv.raw |= u64(rawr) << (i << 4);    mv.inf += score; break;
+				case action::down:  mv.raw |= spread(rawr) << (i << 2); mv.inf += score; break;
+				case action::left:  mv.raw |= u64(rawl) << (i << 4);    mv.inf += score; break;
+				}
+			}
+			template<u32 op, u32 i> inline void move80(board& mv) const {
+				switch (op) {
+				case action::up:    mv.ext |= spreadx(extx & 0x0f) << i;    break;
+				case action::right: mv.ext |= u16(extx >> 4) << (i << 2);   break;
+				case action::down:  mv.ext |= spreadx(extx >> 4) << i;      break;
+				case action::left:  mv.ext |= u16(extx & 0x0f) << (i << 2); break;
+				}
+				move64<op, i>(mv);
+			}
+			template<int i> inline void moveh64(board& L, board& R) const {
+				move64<action::left,  i>(L);
+				move64<action::right, i>(R);
+			}
+			template<int i> inline void moveh80(board& L, board& R) const {
+				move80<action::left,  i>(L);
+				move80<action::right, i>(R);
+			}
+			template<int i> inline void movev64(board& U, board& D) const {
+				move64<action::up,   i>(U);
+				move64<action::down, i>(D);
+			}
+			template<int i> inline void movev80(board& U, board& D) const {
+				move80<action::up,   i>(U);
+				move80<action::down, i>(D);
+			}
+
+			template<u32 blk> constexpr static std::array<move, 1 << 14> make16() {
+				std::array<move, 1 << 14> block;
+				for (u32 i = 0; i < (1 << 14); i++) block[i] = move((blk << 14) | i);
+				return block;
+			}
+			constexpr static std::array<move, 1 << 16> make16() { // evaluate in blocks to stay within the constexpr operation limit
+				constexpr std::array<move, 1 << 14> b0 = make16<0>(), b1 = make16<1>(), b2 = make16<2>(), b3 = make16<3>();
+				std::array<move, 1 << 16> block;
+				for (u32 i = 0; i < (1 << 14); i++) {
+					block[(0 << 14) | i] = b0[i];
+					block[(1 << 14) | i] = b1[i];
+					block[(2 << 14) | i] = b2[i];
+					block[(3 << 14) | i] = b3[i];
+				}
+				return block;
+			}
+
+		public:
+			u16 rawl;       // 16-bit raw after moving left/up
+			u16 rawr;       // 16-bit raw after moving right/down
+			u32 score : 24; // merge score (reward), enough for any reachable tile
+			u32 extx  : 8;  // 4-bit extra after moving left/up (low) and right/down (high)
+		};
+
+	protected:
+		constexpr static inline std::array<u32, 4> unpack(u32 src) {
+			std::array<u32, 4> row = {};
+			for (u32 i = 0; i < 4; i++) row[i] = ((src >> (i << 2)) & 0x0f) | ((src >> (i + 12)) & 0x10);
+			return row;
 		}
 
 	public:
@@ -186,14 +216,14 @@ public:
 		u8   legal;   // legal actions (4-bit)
 		u32  species; // species of this row
 		hexa numof;   // number of each tile-type
-		move mvl;     // LUT for moving left/up
-		move mvr;     // LUT for moving right/down
 		u32  score;   // merge score (reward)
 		u8   merge;   // number of merged tiles
 		i8   moved;   // moved (-1) or not (0)
 		u16  mono;    // cell relationship (12-bit)
 	};
 
+public:
+
 	inline const cache& qrow(u32 i) const { return qrow16(i); }
 	inline const cache& qrow16(u32 i) const { return cache::load(row16(i)); }
 	inline const cache& qrow20(u32 i) const { return cache::load(row20(i)); }
@@ -202,6 +232,11 @@ public:
 	inline const cache& qcol16(u32 i) const { return cache::load(col16(i)); }
 	inline const cache& qcol20(u32 i) const { return cache::load(col20(i)); }
 
+	inline const cache::move& mrow16(u32 i) const { return cache::move::load16(row16(i)); }
+	inline const cache::move& mrow20(u32 i) const { return cache::move::load(row20(i)); }
+	inline const cache::move& mcol16(u32 i) const { return cache::move::load16(col16(i)); }
+	inline const cache::move& mcol20(u32 i) const { return cache::move::load(col20(i)); }
+
 	inline constexpr u32 row(u32 i) const { return row16(i); }
 	inline constexpr u32 row16(u32 i) const {
 		return u32(raw >> (i << 4)) & 0xffff;
@@ -532,74 +567,74 @@ public:
 
 	inline i32 left64() {
 		board move(0, ext, opt, 0);
-		qrow16(0).move64<action::left, 0>(move);
-		qrow16(1).move64<action::left, 1>(move);
-		qrow16(2).move64<action::left, 2>(move);
-		qrow16(3).move64<action::left, 3>(move);
+		mrow16(0).move64<action::left, 0>(move);
+		mrow16(1).move64<action::left, 1>(move);
+		mrow16(2).move64<action::left, 2>(move);
+		mrow16(3).move64<action::left, 3>(move);
 		move.inf |= (move.raw ^ raw) ? 0 : -1;
 		return operator =(move).inf;
 	}
 	inline i32 right64() {
 		board move(0, ext, opt, 0);
-		qrow16(0).move64<action::right, 0>(move);
-		qrow16(1).move64<action::right, 1>(move);
-		qrow16(2).move64<action::right, 2>(move);
-		qrow16(3).move64<action::right, 3>(move);
+		mrow16(0).move64<action::right, 0>(move);
+		mrow16(1).move64<action::right, 1>(move);
+		mrow16(2).move64<action::right, 2>(move);
+		mrow16(3).move64<action::right, 3>(move);
 		move.inf |= (move.raw ^ raw) ? 0 : -1;
 		return operator =(move).inf;
 	}
 	inline i32 up64() {
 		board move(0, ext, opt, 0);
-		qcol16(0).move64<action::up, 0>(move);
-		qcol16(1).move64<action::up, 1>(move);
-		qcol16(2).move64<action::up, 2>(move);
-		qcol16(3).move64<action::up, 3>(move);
+		mcol16(0).move64<action::up, 0>(move);
+		mcol16(1).move64<action::up, 1>(move);
+		mcol16(2).move64<action::up, 2>(move);
+		mcol16(3).move64<action::up, 3>(move);
 		move.inf |= (move.raw ^ raw) ? 0 : -1;
 		return operator =(move).inf;
 	}
 	inline i32 down64() {
 		board move(0, ext, opt, 0);
-		qcol16(0).move64<action::down, 0>(move);
-		qcol16(1).move64<action::down, 1>(move);
-		qcol16(2).move64<action::down, 2>(move);
-		qcol16(3).move64<action::down, 3>(move);
+		mcol16(0).move64<action::down, 0>(move);
+		mcol16(1).move64<action::down, 1>(move);
+		mcol16(2).move64<action::down, 2>(move);
+		mcol16(3).move64<action::down, 3>(move);
 		move.inf |= (move.raw ^ raw) ? 0 : -1;
 		return operator =(move).inf;
 	}
 
 	inline i32 left80() {
 		board move(0, 0, opt, 0);
-		qrow20(0).move80<action::left, 0>(move);
-		qrow20(1).move80<action::left, 1>(move);
-		qrow20(2).move80<action::left, 2>(move);
-		qrow20(3).move80<action::left, 3>(move);
+		mrow20(0).move80<action::left, 0>(move);
+		mrow20(1).move80<action::left, 1>(move);
+		mrow20(2).move80<action::left, 2>(move);
+		mrow20(3).move80<action::left, 3>(move);
 		move.inf |= (move.raw ^ raw) | (move.ext ^ ext) ? 0 : -1;
 		return operator =(move).inf;
 	}
 	inline i32 right80() {
 		board move(0, 0, opt, 0);
-		qrow20(0).move80<action::right, 0>(move);
-		qrow20(1).move80<action::right, 1>(move);
-		qrow20(2).move80<action::right, 2>(move);
-		qrow20(3).move80<action::right, 3>(move);
+		mrow20(0).move80<action::right, 0>(move);
+		mrow20(1).move80<action::right, 1>(move);
+		mrow20(2).move80<action::right, 2>(move);
+		mrow20(3).move80<action::right, 3>(move);
 		move.inf |= (move.raw ^ raw) | (move.ext ^ ext) ? 0 : -1;
 		return operator =(move).inf;
 	}
 	inline i32 up80() {
 		board move(0, 0, opt, 0);
-		qcol20(0).move80<action::up, 0>(move);
-		qcol20(1).move80<action::up, 1>(move);
-		qcol20(2).move80<action::up, 2>(move);
-		qcol20(3).move80<action::up, 3>(move);
+		mcol20(0).move80<action::up, 0>(move);
+		mcol20(1).move80<action::up, 1>(move);
+		mcol20(2).move80<action::up, 2>(move);
+		mcol20(3).move80<action::up, 3>(move);
 		move.inf |= (move.raw ^ raw) | (move.ext ^ ext) ? 0 : -1;
 		return operator =(move).inf;
 	}
 	inline i32 down80() {
 		board move(0, 0, opt, 0);
-		qcol20(0).move80<action::down, 0>(move);
-		qcol20(1).move80<action::down, 1>(move);
-		qcol20(2).move80<action::down, 2>(move);
-		qcol20(3).move80<action::down, 3>(move);
+		mcol20(0).move80<action::down, 0>(move);
+		mcol20(1).move80<action::down, 1>(move);
+		mcol20(2).move80<action::down, 2>(move);
+		mcol20(3).move80<action::down, 3>(move);
 		move.inf |= (move.raw ^ raw) | (move.ext ^ ext) ? 0 : -1;
 		return operator =(move).inf;
 	}
@@ -714,37 +749,119 @@ public:
 #else // if AVX2 is unavailable or disabled
 		U = R = D = L = board();
 
-		qrow16(0).moveh64<0>(L, R);
-		qrow16(1).moveh64<1>(L, R);
-		qrow16(2).moveh64<2>(L, R);
-		qrow16(3).moveh64<3>(L, R);
+		mrow16(0).moveh64<0>(L, R);
+		mrow16(1).moveh64<1>(L, R);
+		mrow16(2).moveh64<2>(L, R);
+		mrow16(3).moveh64<3>(L, R);
 		L.inf |= (L.raw ^ raw) ? 0 : -1;
 		R.inf |= (R.raw ^ raw) ? 0 : -1;
 
-		qcol16(0).movev64<0>(U, D);
-		qcol16(1).movev64<1>(U, D);
-		qcol16(2).movev64<2>(U, D);
-		qcol16(3).movev64<3>(U, D);
+		mcol16(0).movev64<0>(U, D);
+		mcol16(1).movev64<1>(U, D);
+		mcol16(2).movev64<2>(U, D);
+		mcol16(3).movev64<3>(U, D);
 		U.inf |= (U.raw ^ raw) ? 0 : -1;
 		D.inf |= (D.raw ^ raw) ? 0 : -1;
 #endif
 	}
 	inline void moves80(board& U, board& R, board& D, board& L) const {
+#if defined(__AVX2__) && !defined(PREFER_LUT_MOVES)
+		__m256i dst, buf, rbf, rwd, chk, lft, cel;
+
+		// unpack to 16 cells of 8-bit, cell i = (raw >> 4i) & 15 | ((ext >> i) & 1) << 4
+		__m128i x = _mm_cvtsi64_si128(raw), e = _mm_cvtsi32_si128(ext);
+		x = _mm_unpacklo_epi8(_mm_and_si128(x, _mm_set1_epi8(0x0f)), _mm_and_si128(_mm_srli_epi16(x, 4), _mm_set1_epi8(0x0f)));
+		e = _mm_shuffle_epi8(e, _mm_set_epi8(1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0));
+		e = _mm_cmpeq_epi8(_mm_and_si128(e, _mm_set1_epi64x(0x8040201008040201ull)), _mm_set1_epi64x(0x8040201008040201ull));
+		x = _mm_or_si128(x, _mm_and_si128(e, _mm_set1_epi8(0x10)));
+
+		// use left for all 4 directions, each row is a 32-bit lane; transpose and mirror by shuffling cells
+		lft = _mm256_broadcastsi128_si256(x);
+		dst = _mm256_shuffle_epi8(lft, _mm256_set_epi8( // R, U
+				12, 13, 14, 15,  8,  9, 10, 11,  4,  5,  6,  7,  0,  1,  2,  3,
+				15, 11,  7,  3, 14, 10,  6,  2, 13,  9,  5,  1, 12,  8,  4,  0));
+		lft = _mm256_shuffle_epi8(lft, _mm256_set_epi8( // L, D
+				15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  0,
+				 3,  7, 11, 15,  2,  6, 10, 14,  1,  5,  9, 13,  0,  4,  8, 12));
+
+		// slide to left most, then merge same tiles; only the rewards of U and R are collected
+		cel = _mm256_set1_epi32(0xff);
+		rwd = _mm256_setzero_si256();
+		for (__m256i* row : { &dst, &lft }) {
+			__m256i& v = *row;
+			chk = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(v, _mm256_set1_epi32(0x00ff0000)), _mm256_setzero_si256()), _mm256_set1_epi32(0xffff0000));
+			v = _mm256_blendv_epi8(v, _mm256_srli_epi32(v, 8), chk);
+			chk = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(v, _mm256_set1_epi32(0x0000ff00)), _mm256_setzero_si256()), _mm256_set1_epi32(0xffffff00));
+			v = _mm256_blendv_epi8(v, _mm256_srli_epi32(v, 8), chk);
+			chk = _mm256_cmpeq_epi32(_mm256_and_si256(v, cel), _mm256_setzero_si256());
+			v = _mm256_blendv_epi8(v, _mm256_srli_epi32(v, 8), chk);
+
+			buf = _mm256_srli_epi32(_mm256_add_epi32(v, _mm256_set1_epi32(0x00000100)), 8);
+			rbf = _mm256_and_si256(v, cel);
+			chk = _mm256_and_si256(_mm256_srli_epi32(v, 8), cel);
+			chk = _mm256_andnot_si256(_mm256_cmpeq_epi32(rbf, _mm256_setzero_si256()), _mm256_cmpeq_epi32(rbf, chk));
+			v = _mm256_blendv_epi8(v, buf, chk);
+			if (row == &dst) rwd = _mm256_add_epi32(rwd, _mm256_sllv_epi32(_mm256_srli_epi32(chk, 31), _mm256_add_epi32(rbf, _mm256_set1_epi32(1))));
+
+			buf = _mm256_add_epi32(_mm256_srli_epi32(v, 8), _mm256_set1_epi32(0x00000100));
+			rbf = _mm256_and_si256(buf, cel);
+			chk = _mm256_and_si256(_mm256_srli_epi32(v, 16), cel);
+			chk = _mm256_andnot_si256(_mm256_cmpeq_epi32(rbf, _mm256_setzero_si256()), _mm256_cmpeq_epi32(rbf, chk));
+			v = _mm256_blendv_epi8(v, buf, _mm256_and_si256(chk, _mm256_set1_epi32(0xffffff00)));
+			if (row == &dst) rwd = _mm256_add_epi32(rwd, _mm256_sllv_epi32(_mm256_srli_epi32(chk, 31), _mm256_add_epi32(rbf, _mm256_set1_epi32(1))));
+
+			buf = _mm256_srli_epi32(_mm256_add_epi32(v, _mm256_set1_epi32(0x01000000)), 8);
+			rbf = _mm256_srli_epi32(v, 24);
+			chk = _mm256_and_si256(_mm256_srli_epi32(v, 16), cel);
+			chk = _mm256_andnot_si256(_mm256_cmpeq_epi32(rbf, _mm256_setzero_si256()), _mm256_cmpeq_epi32(rbf, chk));
+			v = _mm256_blendv_epi8(v, buf, _mm256_and_si256(chk, _mm256_set1_epi32(0xffff0000)));
+			if (row == &dst) rwd = _mm256_add_epi32(rwd, _mm256_sllv_epi32(_mm256_srli_epi32(chk, 31), _mm256_add_epi32(rbf, _mm256_set1_epi32(1))));
+		}
+
+		// mirror and transpose back to original direction
+		dst = _mm256_shuffle_epi8(dst, _mm256_set_epi8( // R, U
+				12, 13, 14, 15,  8,  9, 10, 11,  4,  5,  6,  7,  0,  1,  2,  3,
+				15, 11,  7,  3, 14, 10,  6,  2, 13,  9,  5,  1, 12,  8,  4,  0));
+		lft = _mm256_shuffle_epi8(lft, _mm256_set_epi8( // L, D
+				15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  0,
+				12,  8,  4,  0, 13,  9,  5,  1, 14, 10,  6,  2, 15, 11,  7,  3));
+
+		// pack to 64-bit raw and 16-bit ext
+		u32 extUR = _mm256_movemask_epi8(_mm256_slli_epi16(dst, 3));
+		u32 extDL = _mm256_movemask_epi8(_mm256_slli_epi16(lft, 3));
+		dst = _mm256_maddubs_epi16(_mm256_and_si256(dst, _mm256_set1_epi8(0x0f)), _mm256_set1_epi16(0x1001));
+		lft = _mm256_maddubs_epi16(_mm256_and_si256(lft, _mm256_set1_epi8(0x0f)), _mm256_set1_epi16(0x1001));
+		dst = _mm256_packus_epi16(dst, lft); // U, D, R, L
+
+		// sum the final reward and check moved or not
+		rwd = _mm256_add_epi32(rwd, _mm256_srli_si256(rwd, 8 /* bytes */));
+		rwd = _mm256_add_epi32(rwd, _mm256_srli_si256(rwd, 4 /* bytes */));
+		U = board(_mm256_extract_epi64(dst, 0), extUR,       _mm256_extract_epi32(rwd, 0));
+		D = board(_mm256_extract_epi64(dst, 1), extDL,       _mm256_extract_epi32(rwd, 0));
+		R = board(_mm256_extract_epi64(dst, 2), extUR >> 16, _mm256_extract_epi32(rwd, 4));
+		L = board(_mm256_extract_epi64(dst, 3), extDL >> 16, _mm256_extract_epi32(rwd, 4));
+		U.inf |= (U.raw ^ raw) | (U.ext ^ ext) ? 0 : -1;
+		R.inf |= (R.raw ^ raw) | (R.ext ^ ext) ? 0 : -1;
+		D.inf |= (D.raw ^ raw) | (D.ext ^ ext) ? 0 : -1;
+		L.inf |= (L.raw ^ raw) | (L.ext ^ ext) ? 0 : -1;
+
+#else // if AVX2 is unavailable or disabled
 		U = R = D = L = board();
 
-		qrow20(0).moveh80<0>(L, R);
-		qrow20(1).moveh80<1>(L, R);
-		qrow20(2).moveh80<2>(L, R);
-		qrow20(3).moveh80<3>(L, R);
+		mrow20(0).moveh80<0>(L, R);
+		mrow20(1).moveh80<1>(L, R);
+		mrow20(2).moveh80<2>(L, R);
+		mrow20(3).moveh80<3>(L, R);
 		L.inf |= (L.raw ^ raw) | (L.ext ^ ext) ? 0 : -1;
 		R.inf |= (R.raw ^ raw) | (R.ext ^ ext) ? 0 : -1;
 
-		qcol20(0).movev80<0>(U, D);
-		qcol20(1).movev80<1>(U, D);
-		qcol20(2).movev80<2>(U, D);
-		qcol20(3).movev80<3>(U, D);
+		mcol20(0).movev80<0>(U, D);
+		mcol20(1).movev80<1>(U, D);
+		mcol20(2).movev80<2>(U, D);
+		mcol20(3).movev80<3>(U, D);
 		U.inf |= (U.raw ^ raw) | (U.ext ^ ext) ? 0 : -1;
 		D.inf |= (D.raw ^ raw) | (D.ext ^ ext) ? 0 : -1;
+#endif
 	}
 
 	template<typename btype, typename = enable_if_is_base_of<board, btype>>
@@ -795,6 +912,113 @@ public:
 	template<typename btype = board, typename = enable_if_is_base_of<board, btype>>
 	inline std::vector<btype> moves80(bool compact) const { btype move[4]; return {move, move + moves80(move, compact).size()}; }
 
+#if defined(__AVX512BW__) && defined(__AVX512DQ__) && !defined(PREFER_LUT_MOVES) && defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push // GCC 12 warns about the undefined passthrough inside AVX-512 intrinsics (PR105593)
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+	static inline void moves_batch(const board src[], board dst[], size_t num) { return moves64_batch(src, dst, num); }
+	static inline void moves64_batch(const board src[], board dst[], size_t num) {
+		// dst[4i+0] ~ dst[4i+3] are the U, R, D, L afterstates of src[i]
+		size_t i = 0;
+#if defined(__AVX512BW__) && defined(__AVX512DQ__) && !defined(PREFER_LUT_MOVES)
+		for (; i + 2 <= num; i += 2) moves64x2(src[i], src[i + 1], dst + (i << 2));
+#endif
+		// with AVX2, each board fills a 256-bit register; consecutive boards are independent chains
+		for (; i < num; i++) src[i].moves64(dst[(i << 2) + 0], dst[(i << 2) + 1], dst[(i << 2) + 2], dst[(i << 2) + 3]);
+	}
+
+#if defined(__AVX512BW__) && defined(__AVX512DQ__) && !defined(PREFER_LUT_MOVES)
+	static inline void moves64x2(const board& b0, const board& b1, board move[]) {
+		__m512i dst, buf, rbf, rwd, chk;
+		auto cmpeq16 = [](__m512i a, __m512i b) { return _mm512_movm_epi16(_mm512_cmpeq_epi16_mask(a, b)); };
+
+		// use left for all 8 directions of two boards, transpose and mirror first
+		u64 r0 = b0.raw, r1 = b1.raw, x0 = r0, x1 = r1;
+		raw_cast<board>(x0).transpose64();
+		raw_cast<board>(x1).transpose64();
+		dst = _mm512_set_epi64(r1, 0, r0, 0, 0, x1, 0, x0); // L1, 0, L0, 0, 0, U1, 0, U0
+		buf = _mm512_set_epi64(0, x1, 0, x0, r1, 0, r0, 0); // 0, D1, 0, D0, R1, 0, R0, 0
+		dst = _mm512_or_si512(dst, _mm512_slli_epi16(buf, 12));
+		dst = _mm512_or_si512(dst, _mm512_slli_epi16(_mm512_and_si512(buf, _mm512_set1_epi16(0x00f0)), 4));
+		dst = _mm512_or_si512(dst, _mm512_srli_epi16(_mm512_and_si512(buf, _mm512_set1_epi16(0x0f00)), 4));
+		dst = _mm512_or_si512(dst, _mm512_srli_epi16(buf, 12));
+
+		// slide to left most
+		buf = _mm512_and_si512(dst, _mm512_set1_epi16(0x0f00));
+		chk = _mm512_and_si512(cmpeq16(buf, _mm512_setzero_si512()), _mm512_set1_epi16(0xff00));
+		dst = _mm512_or_si512(_mm512_and_si512(chk, _mm512_srli_epi16(dst, 4)), _mm512_andnot_si512(chk, dst));
+		buf = _mm512_and_si512(dst, _mm512_set1_epi16(0x00f0));
+		chk = _mm512_and_si512(cmpeq16(buf, _mm512_setzero_si512()), _mm512_set1_epi16(0xfff0));
+		dst = _mm512_or_si512(_mm512_and_si512(chk, _mm512_srli_epi16(dst, 4)), _mm512_andnot_si512(chk, dst));
+		buf = _mm512_and_si512(dst, _mm512_set1_epi16(0x000f));
+		chk = cmpeq16(buf, _mm512_setzero_si512());
+		dst = _mm512_or_si512(_mm512_and_si512(chk, _mm512_srli_epi16(dst, 4)), _mm512_andnot_si512(chk, dst));
+
+		// merge same tiles, slide if necessary (rewards are only collected from U and R lanes)
+		buf = _mm512_srli_epi16(_mm512_add_epi8(dst, _mm512_set1_epi16(0x0010)), 4);
+		rbf = _mm512_and_si512(dst, _mm512_set1_epi16(0x000f));
+		chk = _mm512_and_si512(_mm512_srli_epi16(dst, 4), _mm512_set1_epi16(0x000f));
+		chk = _mm512_andnot_si512(cmpeq16(rbf, _mm512_setzero_si512()), cmpeq16(rbf, chk));
+		dst = _mm512_or_si512(_mm512_and_si512(chk, buf), _mm512_andnot_si512(chk, dst));
+		chk = _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(_mm512_and_si512(chk, _mm512_set1_epi16(0x0001)), 0));
+		rbf = _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(_mm512_add_epi16(rbf, _mm512_set1_epi16(0x0001)), 0));
+		rwd = _mm512_sllv_epi32(chk, rbf);
+
+		buf = _mm512_add_epi8(_mm512_srli_epi16(dst, 4), _mm512_set1_epi16(0x0010));
+		rbf = _mm512_and_si512(buf, _mm512_set1_epi16(0x000f));
+		chk = _mm512_and_si512(_mm512_srli_epi16(dst, 8), _mm512_set1_epi16(0x000f));
+		chk = _mm512_andnot_si512(cmpeq16(rbf, _mm512_setzero_si512()), cmpeq16(rbf, chk));
+		chk = _mm512_and_si512(chk, _mm512_set1_epi16(0xfff0));
+		dst = _mm512_or_si512(_mm512_and_si512(chk, buf), _mm512_andnot_si512(chk, dst));
+		chk = _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(_mm512_srli_epi16(chk, 15), 0));
+		rbf = _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(_mm512_add_epi16(rbf, _mm512_set1_epi16(0x0001)), 0));
+		rwd = _mm512_add_epi32(rwd, _mm512_sllv_epi32(chk, rbf));
+
+		buf = _mm512_srli_epi16(_mm512_add_epi16(dst, _mm512_set1_epi16(0x1000)), 4);
+		rbf = _mm512_srli_epi16(dst, 12);
+		chk = _mm512_and_si512(_mm512_srli_epi16(dst, 8), _mm512_set1_epi16(0x000f));
+		chk = _mm512_andnot_si512(cmpeq16(rbf, _mm512_setzero_si512()), cmpeq16(rbf, chk));
+		chk = _mm512_and_si512(chk, _mm512_set1_epi16(0xff00));
+		dst = _mm512_or_si512(_mm512_and_si512(chk, buf), _mm512_andnot_si512(chk, dst));
+		chk = _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(_mm512_srli_epi16(chk, 15), 0));
+		rbf = _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(_mm512_add_epi16(rbf, _mm512_set1_epi16(0x0001)), 0));
+		rwd = _mm512_add_epi32(rwd, _mm512_sllv_epi32(chk, rbf));
+
+		// mirror R and D back, then transpose U and D back
+		buf = _mm512_slli_epi16(dst, 12);
+		buf = _mm512_or_si512(buf, _mm512_slli_epi16(_mm512_and_si512(dst, _mm512_set1_epi16(0x00f0)), 4));
+		buf = _mm512_or_si512(buf, _mm512_srli_epi16(_mm512_and_si512(dst, _mm512_set1_epi16(0x0f00)), 4));
+		buf = _mm512_or_si512(buf, _mm512_srli_epi16(dst, 12));
+		dst = _mm512_mask_blend_epi64(0b01011010, dst, buf);
+		buf = dst;
+		rbf = _mm512_and_si512(_mm512_xor_si512(buf, _mm512_srli_epi64(buf, 12)), _mm512_set1_epi64(0x0000f0f00000f0f0ull));
+		buf = _mm512_xor_si512(buf, _mm512_xor_si512(rbf, _mm512_slli_epi64(rbf, 12)));
+		rbf = _mm512_and_si512(_mm512_xor_si512(buf, _mm512_srli_epi64(buf, 24)), _mm512_set1_epi64(0x00000000ff00ff00ull));
+		buf = _mm512_xor_si512(buf, _mm512_xor_si512(rbf, _mm512_slli_epi64(rbf, 24)));
+		dst = _mm512_mask_blend_epi64(0b01010101, dst, buf);
+
+		// sum the final rewards (U0, R0, U1, R1 at 32-bit lanes 0, 4, 8, 12) and check moved or not
+		rwd = _mm512_add_epi64(rwd, _mm512_bsrli_epi128(rwd, 8 /* bytes */));
+		rwd = _mm512_add_epi64(rwd, _mm512_srli_epi64(rwd, 32));
+		u32 fix = _mm512_cmpeq_epi64_mask(dst, _mm512_set_epi64(r1, r1, r0, r0, r1, r1, r0, r0));
+		alignas(64) u64 mv[8];
+		alignas(64) u32 rw[16];
+		_mm512_store_si512(mv, dst);
+		_mm512_store_si512(rw, rwd);
+		move[0] = board(mv[0], 0, (fix & 0x01) ? -1u : rw[0]);  // U0
+		move[1] = board(mv[1], 0, (fix & 0x02) ? -1u : rw[4]);  // R0
+		move[2] = board(mv[4], 0, (fix & 0x10) ? -1u : rw[0]);  // D0
+		move[3] = board(mv[5], 0, (fix & 0x20) ? -1u : rw[4]);  // L0
+		move[4] = board(mv[2], 0, (fix & 0x04) ? -1u : rw[8]);  // U1
+		move[5] = board(mv[3], 0, (fix & 0x08) ? -1u : rw[12]); // R1
+		move[6] = board(mv[6], 0, (fix & 0x40) ? -1u : rw[8]);  // D1
+		move[7] = board(mv[7], 0, (fix & 0x80) ? -1u : rw[12]); // L1
+	}
+#endif
+#if defined(__AVX512BW__) && defined(__AVX512DQ__) && !defined(PREFER_LUT_MOVES) && defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
 	class action {
 	public:
 		action() = delete;
@@ -1343,4 +1567,11 @@ public:
 
 };
 
+#if !defined(PREFER_RUNTIME_LUT)
+inline const board::cache::move& board::cache::move::load16(u32 i) {
+	static constexpr std::array<move, 1 << 16> block = make16();
+	return block[i];
+}
+#endif
+
 } // namespace moporgic
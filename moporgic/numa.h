@@ -0,0 +1,145 @@
+#pragma once
+/*
+ * numa.h
+ *  Created on: 2026-10-17
+ *      Author: moporgic
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace moporgic {
+class numa {
+public:
+	/**
+	 * parse a cpu or node list, e.g., "0-3,8-11"
+	 */
+	static std::vector<int> parse(const std::string& res) {
+		std::vector<int> list;
+		std::stringstream tokens(res);
+		for (std::string token; std::getline(tokens, token, ','); ) {
+			int i = -1, n = -1; char x = '.';
+			std::stringstream(token) >> i >> x >> n;
+			if (i == -1) continue;
+			if (x != '-' || n < i) n = i;
+			while (i <= n) list.push_back(i++);
+		}
+		return list;
+	}
+
+#if defined(__linux__) && defined(SYS_mbind) && !defined(NONUMA)
+	static constexpr bool support() { return true; }
+
+	/**
+	 * the online nodes, each of which is a node id and its cpus
+	 */
+	static const std::vector<std::pair<int, std::vector<int>>>& nodes() {
+		static std::vector<std::pair<int, std::vector<int>>> nodes = ({
+			std::vector<std::pair<int, std::vector<int>>> list;
+			std::string online;
+			std::ifstream("/sys/devices/system/node/online", std::ios::in) >> online;
+			for (int id : parse(online)) {
+				std::string cpus;
+				std::ifstream("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist", std::ios::in) >> cpus;
+				if (parse(cpus).size()) list.emplace_back(id, parse(cpus));
+			}
+			list;
+		});
+		return nodes;
+	}
+	static size_t count() { return std::max(nodes().size(), size_t(1)); }
+
+	/**
+	 * bind the calling thread to the cpus of a node, and prefer its local memory
+	 */
+	static bool bind(size_t node) {
+		if (node >= nodes().size()) return false;
+		origin();
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (int cpu : nodes()[node].second) CPU_SET(cpu, &set);
+		mask_t mask = make_mask({ nodes()[node].first });
+		syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask.data(), mask.size() * 64);
+		return sched_setaffinity(0, sizeof(set), &set) == 0;
+	}
+	/**
+	 * restore the affinity and the memory policy before the first bind
+	 */
+	static void reset() {
+		syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0);
+		sched_setaffinity(0, sizeof(cpu_set_t), &origin());
+	}
+
+	/**
+	 * move the pages of a region to a node, or interleave them over all nodes
+	 */
+	static bool place(void* mem, size_t size, size_t node) {
+		if (node >= nodes().size()) return false;
+		return policy(mem, size, MPOL_BIND, make_mask({ nodes()[node].first }));
+	}
+	static bool interleave(void* mem, size_t size) {
+		std::vector<int> ids;
+		for (auto& node : nodes()) ids.push_back(node.first);
+		return policy(mem, size, MPOL_INTERLEAVE, make_mask(ids));
+	}
+
+	/**
+	 * allocate an anonymous region bound to a node, the pages are not touched
+	 */
+	static void* alloc(size_t size, size_t node) {
+		void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (mem == MAP_FAILED) throw std::bad_alloc();
+		place(mem, size, node);
+		return mem;
+	}
+	static void free(void* mem, size_t size) {
+		munmap(mem, size);
+	}
+
+private:
+	enum { MPOL_DEFAULT = 0, MPOL_PREFERRED = 1, MPOL_BIND = 2, MPOL_INTERLEAVE = 3 };
+	enum { MPOL_MF_MOVE = 1 << 1 };
+	typedef std::vector<unsigned long> mask_t;
+
+	static mask_t make_mask(const std::vector<int>& ids) {
+		mask_t mask(16, 0); // up to 1024 nodes
+		for (int id : ids) mask[id / 64] |= 1ul << (id % 64);
+		return mask;
+	}
+	static bool policy(void* mem, size_t size, int mode, const mask_t& mask) {
+		size_t page = sysconf(_SC_PAGESIZE);
+		uintptr_t beg = (uintptr_t(mem) + page - 1) & ~(page - 1), end = (uintptr_t(mem) + size) & ~(page - 1);
+		if (end <= beg) return false;
+		return syscall(SYS_mbind, beg, end - beg, mode, mask.data(), mask.size() * 64, MPOL_MF_MOVE) == 0;
+	}
+	static cpu_set_t& origin() {
+		static cpu_set_t set = ({ cpu_set_t set; sched_getaffinity(0, sizeof(set), &set); set; });
+		return set;
+	}
+
+#else /* if numa is not supported */
+	static constexpr bool support() { return false; }
+	static const std::vector<std::pair<int, std::vector<int>>>& nodes() { static std::vector<std::pair<int, std::vector<int>>> nodes; return nodes; }
+	static size_t count() { return 1; }
+	static bool bind(size_t node) { return false; }
+	static void reset() {}
+	static bool place(void* mem, size_t size, size_t node) { return false; }
+	static bool interleave(void* mem, size_t size) { return false; }
+	static void* alloc(size_t size, size_t node) { void* mem = std::malloc(size); if (!mem) throw std::bad_alloc(); return mem; }
+	static void free(void* mem, size_t size) { std::free(mem); }
+#endif /* end if */
+};
+
+} // namespace moporgic
@@ -0,0 +1,205 @@
+#pragma once
+/*
+ * page.h
+ *  Created on: 2026-10-17
+ *      Author: moporgic
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <map>
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace moporgic {
+class page {
+public:
+	enum backing { normal = 0, thp = 1, hugetlb = 2 };
+	static constexpr size_t align = 1 << 16; // alignment of mapped file contents, fits 4K, 16K, and 64K pages
+
+	static int& policy() { static int use = normal; return use; }
+	static bool enable() { return policy() != normal; }
+	static void policy(const std::string& use) {
+		policy() = use == "hugetlb" || use == "huge" ? hugetlb : use == "thp" || use == "madvise" ? thp : normal;
+	}
+	static const char* name(int use) {
+		return use == hugetlb ? "hugetlb" : use == thp ? "thp" : "normal";
+	}
+
+	/**
+	 * the amount of bytes obtained with each backing, i.e., normal, thp, and hugetlb
+	 */
+	static std::array<size_t, 3>& usage() { static std::array<size_t, 3> use = {}; return use; }
+	static void record(size_t size, int use) { usage()[use] += size; }
+
+#if defined(__linux__) && !defined(NOHUGEPAGE)
+	static constexpr bool support() { return true; }
+
+	static size_t huge_size() {
+		static size_t size = ({
+			size_t kb = 2048;
+			std::ifstream in("/proc/meminfo", std::ios::in);
+			for (std::string line; std::getline(in, line); )
+				if (line.find("Hugepagesize:") == 0) kb = std::stoull(line.substr(13));
+			kb << 10;
+		});
+		return size;
+	}
+
+	/**
+	 * try to back the region with transparent huge pages
+	 */
+	static bool advise(void* mem, size_t size) {
+		return madvise(mem, size, MADV_HUGEPAGE) == 0;
+	}
+
+	/**
+	 * allocate a region for the given type, or only reserve it if lazy is set
+	 * a lazy region is not constructed, which assumes that the default of the type is all zero
+	 */
+	template<typename type = void> static type* alloc(size_t size, bool lazy = false) {
+		if (lazy) return cast<type*>(reserve(size * sizeof(type)));
+		if (!enable()) return new type[size]();
+		size_t huge = huge_size(), len = ((size * sizeof(type)) + huge - 1) & ~(huge - 1);
+		int prot = PROT_READ | PROT_WRITE, flag = MAP_PRIVATE | MAP_ANONYMOUS;
+		int use = hugetlb;
+		void* mem = policy() == hugetlb ? mmap(nullptr, len, prot, flag | MAP_HUGETLB, -1, 0) : MAP_FAILED;
+		if (mem == MAP_FAILED) { // over-map and trim so that the region is aligned to the huge page size
+			char* raw = cast<char*>(mmap(nullptr, len + huge, prot, flag, -1, 0));
+			if (raw == MAP_FAILED) throw std::bad_alloc();
+			char* beg = cast<char*>((cast<uintptr_t>(raw) + huge - 1) & ~(huge - 1));
+			if (beg != raw) munmap(raw, beg - raw);
+			if (beg + len != raw + len + huge) munmap(beg + len, (raw + len + huge) - (beg + len));
+			mem = beg;
+			use = advise(mem, len) ? thp : normal;
+		}
+		info().emplace(mem, std::make_pair(len, size));
+		record(len, use);
+		try {
+			new (cast<type*>(mem)) type[size]();
+		} catch (...) {}
+		return cast<type*>(mem);
+	}
+
+	/**
+	 * reserve an anonymous region whose pages are committed as zero on the first write
+	 * the region uses small pages so that scattered writes commit as little as possible
+	 */
+	static void* reserve(size_t size) {
+		size_t len = (size + sysconf(_SC_PAGESIZE) - 1) & ~(sysconf(_SC_PAGESIZE) - 1);
+		void* mem = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (mem == MAP_FAILED) throw std::bad_alloc();
+		madvise(mem, len, MADV_NOHUGEPAGE);
+		info().emplace(mem, std::make_pair(len, 0));
+		return mem;
+	}
+
+	/**
+	 * the amount of bytes of a region that have been touched, i.e., the resident pages
+	 */
+	static size_t resident(const void* mem, size_t size) {
+		size_t page = sysconf(_SC_PAGESIZE);
+		uintptr_t beg = cast<uintptr_t>(mem) & ~(page - 1), end = cast<uintptr_t>(mem) + size;
+		std::vector<unsigned char> vec((end - beg + page - 1) / page);
+		if (vec.empty() || mincore(cast<void*>(beg), end - beg, vec.data()) != 0) return size;
+		size_t num = 0;
+		for (unsigned char v : vec) num += v & 1;
+		return std::min(num * page, size);
+	}
+
+	/**
+	 * the amount of bytes of a region that have been written, i.e., the resident pages holding non-zero bytes
+	 * pages that were only read are resident as well since they map the shared zero page, so their contents are checked
+	 */
+	static size_t written(const void* mem, size_t size) {
+		size_t page = sysconf(_SC_PAGESIZE);
+		uintptr_t beg = cast<uintptr_t>(mem) & ~(page - 1), end = cast<uintptr_t>(mem) + size;
+		std::vector<unsigned char> vec((end - beg + page - 1) / page);
+		if (vec.empty() || mincore(cast<void*>(beg), end - beg, vec.data()) != 0) return size;
+		std::vector<char> zero(page);
+		size_t num = 0;
+		for (size_t i = 0; i < vec.size(); i++) {
+			if (!(vec[i] & 1)) continue;
+			uintptr_t lo = std::max(beg + i * page, cast<uintptr_t>(mem)), hi = std::min(beg + (i + 1) * page, end);
+			if (std::memcmp(cast<void*>(lo), zero.data(), hi - lo) != 0) num += hi - lo;
+		}
+		return num;
+	}
+
+	/**
+	 * map a file region privately, i.e., pages are shared through the page cache until written
+	 */
+	static void* map(const std::string& path, size_t offset, size_t size) {
+		if (!size || offset % sysconf(_SC_PAGESIZE)) return nullptr;
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd == -1) return nullptr;
+		void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, offset);
+		close(fd);
+		if (mem == MAP_FAILED) return nullptr;
+		madvise(mem, size, MADV_WILLNEED);
+		info().emplace(mem, std::make_pair(size, 0));
+		return mem;
+	}
+
+	template<typename type = void> static void free(type* mem) {
+		auto it = info().find(mem);
+		if (it == info().end()) { delete[] mem; return; }
+		size_t len = it->second.first, size = it->second.second;
+		info().erase(it);
+		try {
+			for (size_t i = 0; i < size; i++) cast<type*>(mem)[i].~type();
+		} catch (...) {}
+		munmap(mem, len);
+	}
+
+	/**
+	 * report the backing obtained so far, e.g., "thp (1024M thp, 1016M AnonHugePages)"
+	 */
+	static std::string report() {
+		std::stringstream out;
+		out << name(policy()) << " (";
+		for (int use : {hugetlb, thp, normal})
+			if (usage()[use]) out << (usage()[use] >> 20) << "M " << name(use) << ", ";
+		std::ifstream in("/proc/self/smaps_rollup", std::ios::in);
+		for (std::string line; std::getline(in, line); ) {
+			if (line.find("AnonHugePages:") && line.find("ShmemPmdMapped:")) continue;
+			std::string label = line.substr(0, line.find(':'));
+			size_t kb = std::stoull(line.substr(label.size() + 1));
+			if (kb) out << (kb >> 10) << "M " << label << ", ";
+		}
+		std::string res = out.str();
+		return res.substr(0, res.size() - 2) + (res.back() == '(' ? " (none)" : ")");
+	}
+
+protected:
+	static std::map<void*, std::pair<size_t, size_t>>& info() {
+		static std::map<void*, std::pair<size_t, size_t>> info;
+		return info;
+	}
+
+#else /* if huge pages and mappings are not supported */
+	static constexpr bool support() { return false; }
+	static size_t huge_size() { return 0; }
+	static bool advise(void* mem, size_t size) { return false; }
+	static void* map(const std::string& path, size_t offset, size_t size) { return nullptr; }
+	template<typename type = void> static type* alloc(size_t size, bool lazy = false) { if (!lazy) record(size * sizeof(type), normal); return new type[size](); }
+	static void* reserve(size_t size) { return alloc<char>(size, true); }
+	static size_t resident(const void* mem, size_t size) { return size; }
+	static size_t written(const void* mem, size_t size) { return size; }
+	template<typename type = void> static void free(type* mem) { delete[] mem; }
+	static std::string report() { return std::string(name(normal)) + " (unsupported)"; }
+#endif /* end if */
+};
+
+} // namespace moporgic
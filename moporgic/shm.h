@@ -8,6 +8,7 @@
 #include <cstdlib>
 #include <cstdint>
 #include <memory>
+#include "page.h"
 #if defined(__linux__)
 #include <sys/shm.h>
 #include <signal.h>
@@ -23,7 +24,11 @@ class shm {
 public:
 	static constexpr bool support() { return true; }
 
-	template<typename type = void> static type* alloc(size_t size) {
+	/**
+	 * allocate a segment for the given type, or only reserve it if lazy is set
+	 * a lazy segment is not constructed, which assumes that the default of the type is all zero
+	 */
+	template<typename type = void> static type* alloc(size_t size, bool lazy = false) {
 		if (!enable<type>()) throw std::invalid_argument("shm is disabled");
 		static uint8_t seq = 0;
 		static std::string hook = ({
@@ -34,13 +39,19 @@ public:
 		});
 		if (++seq == 0) throw std::bad_alloc();
 		auto key = ftok(hook.c_str(), seq);
-		int id = shmget(key, size * sizeof(type), IPC_CREAT | IPC_EXCL | 0600);
+		size_t len = size * sizeof(type);
+		int use = page::policy() == page::hugetlb && !lazy ? page::hugetlb : page::normal;
+		int id = use == page::hugetlb ? shmget(key, len, IPC_CREAT | IPC_EXCL | SHM_HUGETLB | 0600) : -1;
+		if (id == -1) id = shmget(key, len, IPC_CREAT | IPC_EXCL | (lazy ? SHM_NORESERVE : 0) | 0600), use = page::normal;
 		void* shm = shmat(id, nullptr, 0);
 		if (shm == (void*) -1ull) {
-			if (errno & EEXIST) return alloc<type>(size);
+			if (errno & EEXIST) return alloc<type>(size, lazy);
 			throw std::bad_alloc();
 		}
-		info().emplace(shm, std::make_pair(id, size));
+		info().emplace(shm, std::make_pair(id, lazy ? 0 : size));
+		if (lazy) return cast<type*>(shm);
+		if (use == page::normal && page::enable() && page::advise(shm, len)) use = page::thp;
+		page::record(len, use);
 		try {
 			new (cast<type*>(shm)) type[size]();
 		} catch (...) {}
@@ -97,7 +108,7 @@ protected:
 #else /* if shm is not supported */
 public:
 	static constexpr bool support() { return false; }
-	template<typename type = void> static type* alloc(size_t size) { throw std::bad_alloc(); }
+	template<typename type = void> static type* alloc(size_t size, bool lazy = false) { throw std::bad_alloc(); }
 	template<typename type = void> static void free(type* shm) { throw std::bad_alloc(); }
 protected:
 	static void clear() {}
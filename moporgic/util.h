@@ -17,6 +17,7 @@
 #include <chrono>
 #include <random>
 #include <utility>
+#include <algorithm>
 
 #if defined(__GNUC__)
 #define inline_always inline __attribute__((always_inline))
@@ -180,54 +181,114 @@ static inline uint32_t to_hash(const std::string& str) noexcept {
 	return to_hash(str.c_str());
 }
 
-class random {
+/**
+ * xoshiro256** by David Blackman and Sebastiano Vigna, seeded by splitmix64
+ * jump() advances 2^128 draws and long_jump() advances 2^192 draws
+ */
+class xoshiro256ss {
 public:
-	template<typename engine_t = std::mt19937>
-	inline operator uint16_t() const { return next<engine_t>(); }
-	template<typename engine_t = std::mt19937>
-	inline operator uint32_t() const { return next<engine_t>(); }
-	template<typename engine_t = std::mt19937_64>
-	inline operator uint64_t() const { return next<engine_t>(); }
-	template<typename engine_t = std::mt19937>
-	inline operator float() const { return std::uniform_real_distribution<float>(0.0f, 1.0f)(engine_ref<engine_t>()); }
-	template<typename engine_t = std::mt19937_64>
-	inline operator double() const { return std::uniform_real_distribution<double>(0.0, 1.0)(engine_ref<engine_t>()); }
-
-	template<typename engine_t = std::mt19937>
-	static inline auto& engine_ref() { return *(engine_ptr<engine_t>()); }
-	template<typename engine_t = std::mt19937>
-	static inline auto& engine_ptr() { static engine_t* engine = nullptr; return engine; }
-	template<typename engine_t = std::mt19937>
-	static inline auto next() { return (engine_ref<engine_t>())(); }
-
-	template<typename engine_t = std::mt19937, typename seed_t = decltype(engine_t::default_seed)>
-	static inline void init(seed_t seed = engine_t::default_seed) {
-		delete std::exchange(engine_ptr<engine_t>(), new engine_t(seed));
+	typedef uint64_t result_type;
+	constexpr static result_type default_seed = 5489u;
+	constexpr xoshiro256ss(result_type seed = default_seed) : s{} { this->seed(seed); }
+	constexpr xoshiro256ss(const xoshiro256ss&) = default;
+	constexpr xoshiro256ss& operator =(const xoshiro256ss&) = default;
+
+	constexpr static result_type min() { return 0; }
+	constexpr static result_type max() { return ~result_type(0); }
+	constexpr result_type operator()() {
+		uint64_t r = rotl(s[1] * 5, 7) * 9, t = s[1] << 17;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = rotl(s[3], 45);
+		return r;
 	}
-	template<typename engine_t = std::mt19937, typename seed_t = decltype(engine_t::default_seed)>
-	static inline void seed(seed_t seed = engine_t::default_seed) {
-		if (engine_ptr<engine_t>()) engine_ref<engine_t>().seed(seed);
-		else                        init<engine_t>(seed);
+
+	constexpr void seed(result_type seed = default_seed) {
+		for (uint64_t& x : s) {
+			uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			x = z ^ (z >> 31);
+		}
 	}
+	constexpr void discard(unsigned long long n) { while (n--) operator()(); }
+	constexpr void jump()      { jump({ 0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull }); }
+	constexpr void long_jump() { jump({ 0x76e15d3efefdcbbfull, 0xc5004e441c522fb3ull, 0x77710069854ee241ull, 0x39109bb02acbe635ull }); }
+
+	constexpr bool operator ==(const xoshiro256ss& x) const { return std::equal(s, s + 4, x.s); }
+	constexpr bool operator !=(const xoshiro256ss& x) const { return !(*this == x); }
+
 protected:
-	static __attribute__((constructor)) void __init__(void) {
-		init<std::mt19937>(std::mt19937::default_seed);
-		init<std::mt19937_64>(std::mt19937_64::default_seed);
+	constexpr static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+	constexpr void jump(const uint64_t (&poly)[4]) {
+		uint64_t t[4] = {};
+		for (uint64_t p : poly) {
+			for (uint32_t b = 0; b < 64; b++, operator()()) {
+				if (!(p & (1ull << b))) continue;
+				for (uint32_t i = 0; i < 4; i++) t[i] ^= s[i];
+			}
+		}
+		std::copy(t, t + 4, s);
 	}
-	static __attribute__((destructor))  void __exit__(void) {}
+	uint64_t s[4];
 };
 
-static inline void srand(uint32_t seed = to_hash("moporgic")) {
-	random::seed<std::mt19937>(seed);
-	random::seed<std::mt19937_64>(seed);
-}
-static inline uint32_t rand()   { return uint32_t(random()); }
-static inline uint32_t rand16() { return uint32_t(random()) & 0xffffu; }
-static inline uint32_t rand32() { return uint32_t(random()); }
-static inline uint32_t rand31() { return uint32_t(random()) & 0x7fffffffu; }
+/**
+ * thread-local random streams
+ * each thread owns an engine and a small pool of 32-bit draws filled in bulk,
+ * worker streams are derived from a common state by jump() (2^128 draws apart)
+ */
+class random {
+public:
+	typedef xoshiro256ss engine;
+	inline operator uint16_t() const { return next() >> 48; }
+	inline operator uint32_t() const { return next() >> 32; }
+	inline operator uint64_t() const { return next(); }
+	inline operator float() const { return std::uniform_real_distribution<float>(0.0f, 1.0f)(engine_ref()); }
+	inline operator double() const { return std::uniform_real_distribution<double>(0.0, 1.0)(engine_ref()); }
+
+	static inline engine& engine_ref() { return stream().gen; }
+	static inline uint64_t next() { return engine_ref()(); }
+	static inline uint32_t draw() {
+		stream_t& st = stream();
+		if (!st.num) fill(st.buf, st.num = sizeof(st.buf) / sizeof(st.buf[0]));
+		return st.buf[--st.num];
+	}
+	template<typename T>
+	static inline void fill(T* buf, size_t num) {
+		constexpr size_t n = sizeof(uint64_t) / sizeof(T);
+		for (size_t i = 0; i < num; i += n) {
+			uint64_t u = next();
+			for (size_t k = 0; k < n && i + k < num; k++, u >>= (sizeof(T) * 8) % 64) buf[i + k] = T(u);
+		}
+	}
+
+	static inline engine state() { return engine_ref(); }
+	static inline void state(const engine& gen) { stream() = { gen }; }
+	static inline void seed(uint64_t seed = engine::default_seed) { state(engine(seed)); }
+	static inline void jump(uint64_t n = 1)      { engine gen = state(); while (n--) gen.jump();      state(gen); }
+	static inline void long_jump(uint64_t n = 1) { engine gen = state(); while (n--) gen.long_jump(); state(gen); }
+
+protected:
+	struct stream_t {
+		engine gen;
+		uint32_t buf[64];
+		uint32_t num;
+	};
+	static inline stream_t& stream() { static thread_local stream_t st = { engine() }; return st; }
+};
+
+static inline void srand(uint64_t seed = to_hash("moporgic")) { random::seed(seed); }
+static inline uint32_t rand()   { return random::draw(); }
+static inline uint32_t rand16() { return rand() & 0xffffu; }
+static inline uint32_t rand32() { return rand(); }
+static inline uint32_t rand31() { return rand() & 0x7fffffffu; }
 static inline uint64_t rand64() { return uint64_t(random()); }
 static inline uint64_t rand63() { return uint64_t(random()) & 0x7fffffffffffffffull; }
-static inline uint32_t rand24() { return uint32_t(random()) & 0x00ffffffu; }
+static inline uint32_t rand24() { return rand() & 0x00ffffffu; }
 static inline uint32_t randx()  { return rand32(); }
 
 static inline auto rdtsc() {